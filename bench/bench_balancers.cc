@@ -0,0 +1,211 @@
+/*
+ * Balancing algorithm benchmark
+ *
+ * times load_data, offline_lb, offline_lb2, opt_loadbalancer and online_lb
+ * on synthetic diurnal, bursty and flash-crowd traces from 1e3 samples up,
+ * and prints samples/sec, heap allocations and peak RSS of each. every
+ * run is a child process so the RSS is its own. needs no ns-3: the
+ * algorithms are timed through the code LoadBalancer and Network call
+ * (trace.h, kernels.h, online.h)
+ *
+ *   g++ -O2 -march=native -std=c++17 -pthread -Ilib bench/bench_balancers.cc -o bench_balancers
+ *   ./bench_balancers [max samples, default 1e8] [seed, default 1] [parse threads, default 1]
+ *
+ * traces longer than 2^26 samples are generated and balanced in 2^26
+ * sample chunks, load_data is capped at 1e8 samples (about 700MB of CSV)
+ *
+ * author: Thato Semoko
+ */
+
+#include "trace.h"
+#include "kernels.h"
+#include "online.h"
+#include "synthetic.h"
+
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+using namespace std;
+
+const double threshold = 0.75;
+const int num_servers  = 8;
+const double capacity  = 0.75*20000*32;
+const size_t max_chunk = size_t(1) << 26;
+const size_t max_file  = size_t(1e8);
+
+// every heap allocation in the process
+static atomic<uint64_t> allocations(0), allocated_bytes(0);
+
+void *operator new(size_t n)
+{
+    allocations.fetch_add(1, memory_order_relaxed);
+    allocated_bytes.fetch_add(n, memory_order_relaxed);
+    void *p = malloc(n ? n : 1);
+    if(p == nullptr) { throw bad_alloc(); }
+    return p;
+}
+
+// out of line, or gcc sees free() on a pointer from operator new and warns
+__attribute__((noinline)) void operator delete(void *p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept { free(p); }
+
+struct Result
+{
+    double seconds;
+    uint64_t samples;
+    uint64_t allocations, bytes;
+    double rss_mb;
+};
+
+enum Algorithm { LOAD_DATA, OFFLINE_LB, OFFLINE_LB2, OPT_LOADBALANCER, ONLINE_LB, ALGORITHMS };
+
+const char *algorithm_name(int a)
+{
+    const char *names[] = {"load_data", "offline_lb", "offline_lb2", "opt_loadbalancer", "online_lb"};
+    return names[a];
+}
+
+/*
+ * time one algorithm over n samples of a trace, only the algorithm's own
+ * time and allocations are counted, not generating the trace
+ */
+Result measure(int algorithm, synthetic::Shape shape, uint64_t seed, size_t n, unsigned threads)
+{
+    Result r = {0, n, 0, 0, 0};
+    chrono::steady_clock::time_point start;
+    uint64_t allocs0, bytes0;
+
+    auto begin = [&]() { allocs0 = allocations.load(); bytes0 = allocated_bytes.load(); start = chrono::steady_clock::now(); };
+    auto end   = [&]()
+    {
+        r.seconds     += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        r.allocations += allocations.load() - allocs0;
+        r.bytes       += allocated_bytes.load() - bytes0;
+    };
+
+    if(algorithm == LOAD_DATA)
+    {
+        r.samples = min(n, max_file);
+        string filename = "/tmp/bench_balancers." + to_string(getpid()) + ".csv";
+        if(!synthetic::write_csv(filename, shape, seed, r.samples, capacity)) { r.seconds = -1; return r; }
+
+        begin();
+        vector<double> load = trace::load(filename, capacity, threads);
+        end();
+
+        unlink(filename.c_str());
+        if(load.size() != r.samples) { r.seconds = -1; }
+        return r;
+    }
+
+    synthetic::Generator gen(shape, seed);
+    online::OnlineBalancer engine(num_servers, threshold, 0.25, 60);
+
+    // the batch calls write into caller owned buffers, sized once per run
+    vector<double> trace(min(n, max_chunk));
+    vector<int> servers, transitions;
+
+    for(size_t done=0; done<n; done+=trace.size())
+    {
+        size_t m = min(trace.size(), n - done);
+        trace.resize(m);
+        gen.fill(trace.data(), m);
+
+        begin();
+        switch(algorithm)
+        {
+            case OFFLINE_LB:
+                servers.resize(m);
+                kernels::provision(trace.data(), m, threshold, num_servers, 1, servers.data());
+                break;
+
+            case OFFLINE_LB2:
+                servers.resize(m);
+                transitions.resize(m - 1);
+                kernels::provision_transitions(trace.data(), m, threshold, num_servers, 1, servers.data(),
+                                               transitions.data());
+                break;
+
+            case OPT_LOADBALANCER:
+                servers.resize(m);
+                kernels::provision(trace.data(), m, threshold, num_servers, 0, servers.data());
+                break;
+
+            default:
+                servers = engine.replay(trace);
+                break;
+        }
+        end();
+    }
+    return r;
+}
+
+Result measure_in_child(int algorithm, synthetic::Shape shape, uint64_t seed, size_t n, unsigned threads)
+{
+    int fds[2];
+    Result result = {-1, 0, 0, 0, -1};
+    if(pipe(fds) != 0) { return result; }
+
+    pid_t pid = fork();
+    if(pid == 0)
+    {
+        close(fds[0]);
+        Result r = measure(algorithm, shape, seed, n, threads);
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        r.rss_mb = usage.ru_maxrss/1024.0;
+
+        ssize_t w = write(fds[1], &r, sizeof(r));
+        _exit(w == sizeof(r) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    if(pid > 0)
+    {
+        ssize_t got = read(fds[0], &result, sizeof(result));
+        if(got != sizeof(result)) { result = Result{-1, 0, 0, 0, -1}; }
+        waitpid(pid, nullptr, 0);
+    }
+    close(fds[0]);
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t max_samples = argc > 1 ? size_t(atof(argv[1])) : size_t(1e8);
+    uint64_t seed      = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1;
+    unsigned threads   = argc > 3 ? atoi(argv[3]) : 1;
+
+    synthetic::Shape shapes[] = {synthetic::DIURNAL, synthetic::BURSTY, synthetic::FLASH_CROWD};
+
+    printf("seed %llu, %u parse thread(s)\n", (unsigned long long)seed, threads);
+    printf("%-12s %-12s %-18s %14s %12s %12s %14s %10s\n", "shape", "samples", "algorithm", "samples/s", "seconds",
+           "allocs", "alloc MB", "RSS MB");
+
+    for(synthetic::Shape shape: shapes)
+    {
+        for(size_t samples=1000; samples<=max_samples; samples*=10)
+        {
+            for(int a=0; a<ALGORITHMS; a++)
+            {
+                Result r = measure_in_child(a, shape, seed, samples, threads);
+                if(r.seconds < 0)
+                {
+                    printf("%-12s %-12zu %-18s %14s\n", synthetic::shape_name(shape), samples, algorithm_name(a), "failed");
+                    continue;
+                }
+                printf("%-12s %-12llu %-18s %14.3e %12.6f %12llu %14.2f %10.1f\n", synthetic::shape_name(shape),
+                       (unsigned long long)r.samples, algorithm_name(a), r.samples/max(r.seconds, 1e-9), r.seconds,
+                       (unsigned long long)r.allocations, r.bytes/1048576.0, r.rss_mb);
+            }
+        }
+    }
+
+    return 0;
+}
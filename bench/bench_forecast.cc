@@ -0,0 +1,63 @@
+/*
+ * Forecasting benchmark
+ *
+ * provisions synthetic diurnal, bursty and flash-crowd traces with a wake
+ * delay of the horizon, reacting to the current sample (offline_lb's rule)
+ * and pre-warming from each forecast, and prints samples/sec with the
+ * change in dropped load and transitions against the reactive run
+ *
+ *   g++ -O2 -march=native -std=c++17 -Ilib bench/bench_forecast.cc -o bench_forecast
+ *   ./bench_forecast [samples, default 1e8] [horizon, default 60] [servers, default 2000]
+ *
+ * author: Thato Semoko
+ */
+
+#include "forecast.h"
+#include "synthetic.h"
+
+#include <vector>
+#include <chrono>
+#include <cstdio>
+
+using namespace std;
+
+const double threshold = 0.75;
+
+int main(int argc, char *argv[])
+{
+    size_t n    = argc > 1 ? size_t(atof(argv[1])) : size_t(1e8);
+    int horizon = argc > 2 ? atoi(argv[2]) : 60;
+    int servers = argc > 3 ? atoi(argv[3]) : 2000;
+
+    synthetic::Shape shapes[] = {synthetic::DIURNAL, synthetic::BURSTY, synthetic::FLASH_CROWD};
+    forecast::Method methods[] = {forecast::NONE, forecast::EWMA, forecast::HOLT_WINTERS, forecast::WINDOW_MAX};
+
+    printf("%zu samples, %d servers, %ds wake delay\n", n, servers, horizon);
+    printf("%-12s %-14s %12s %16s %14s %12s %10s %12s\n", "shape", "forecast", "samples/s", "server-seconds",
+           "transitions", "trans %", "dropped", "dropped %");
+
+    vector<double> load(n);
+    for(synthetic::Shape shape: shapes)
+    {
+        synthetic::Generator(shape, 1).fill(load.data(), n);
+
+        forecast::Outcome base = {0, 0, 0, 0};
+        for(forecast::Method method: methods)
+        {
+            forecast::Config config;
+            config.method  = method;
+            config.horizon = horizon;
+
+            auto start = chrono::steady_clock::now();
+            forecast::Outcome o = forecast::provision(load.data(), n, threshold, servers, config);
+            double t = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if(method == forecast::NONE) { base = o; }
+
+            printf("%-12s %-14s %12.3e %16.0f %14llu %+11.1f%% %10.1f %+11.1f%%\n", synthetic::shape_name(shape),
+                   forecast::method_name(method), n/t, o.server_seconds, (unsigned long long)o.transitions,
+                   base.transitions ? 100.0*(double(o.transitions) - base.transitions)/base.transitions : 0.0,
+                   o.dropped, base.dropped > 0 ? 100.0*(o.dropped - base.dropped)/base.dropped : 0.0);
+        }
+    }
+    return 0;
+}
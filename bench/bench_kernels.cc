@@ -0,0 +1,117 @@
+/*
+ * Batch kernel benchmark
+ *
+ * samples/sec of the scalar offline_lb, offline_lb2 and opt_loadbalancer
+ * loops against the kernels in kernels.h, checking the outputs match
+ *
+ *   g++ -O2 -march=native -std=c++17 -Ilib bench/bench_kernels.cc -o bench_kernels
+ *   ./bench_kernels [max samples, default 1e9]
+ *
+ * traces longer than 2^26 samples are run as repeated passes over a 2^26
+ * sample buffer so a 1e9 sample run fits in memory
+ *
+ * author: Thato Semoko
+ */
+
+#include "kernels.h"
+
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cmath>
+
+using namespace std;
+
+const double threshold = 0.75;
+const int num_servers  = 8;
+
+// the loops in LoadBalancer and Network, with push_back into fresh vectors
+vector<int> scalar_offline_lb(const vector<double> &traffic)
+{
+    vector<int> servers;
+    for(double load: traffic)
+    {
+        int m_t = (int)((load/threshold)*num_servers);
+        if (m_t < 1) { servers.push_back(1); }
+        else if (m_t < num_servers) { servers.push_back(m_t); }
+        else { servers.push_back(num_servers); }
+    }
+    return servers;
+}
+
+vector<int> scalar_offline_lb2(const vector<double> &traffic)
+{
+    vector<int> transitions;
+    int prev = 0;
+    bool first = true;
+    for(double load: traffic)
+    {
+        int m_t = (int)((load/threshold)*num_servers);
+        if (m_t < 1) { m_t = 1; }
+        else if (m_t >= num_servers) { m_t = num_servers; }
+        if(!first) { transitions.push_back(abs(m_t - prev)); }
+        prev = m_t;
+        first = false;
+    }
+    return transitions;
+}
+
+vector<int> scalar_opt(const vector<double> &traffic)
+{
+    vector<int> servers;
+    for(double load: traffic)
+    {
+        int m_t = (int)((load/threshold)*num_servers);
+        if (m_t < 0) { servers.push_back(0); }
+        else if (m_t < num_servers) { servers.push_back(m_t); }
+        else { servers.push_back(num_servers); }
+    }
+    return servers;
+}
+
+template <typename F>
+double rate(size_t samples, size_t buffer, F run)
+{
+    auto start = chrono::steady_clock::now();
+    for(size_t done=0; done<samples; done+=buffer) { run(); }
+    double t = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return samples/t;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t max_samples = argc > 1 ? size_t(atof(argv[1])) : size_t(1e9);
+    size_t max_buffer  = size_t(1) << 26;
+
+    // diurnal load with noise, around the whole clamp range
+    vector<double> load(min(max_samples, max_buffer));
+    mt19937_64 rng(7);
+    normal_distribution<double> noise(0.0, 0.05);
+    for(size_t i=0; i<load.size(); i++) { load[i] = 0.45 + 0.45*sin(i*2*M_PI/86400) + noise(rng); }
+
+    printf("%-12s %-18s %14s %14s %8s\n", "samples", "algorithm", "scalar/s", "kernel/s", "match");
+
+    for(size_t samples=1000000; samples<=max_samples; samples*=10)
+    {
+        size_t buffer = min(samples, max_buffer);
+        vector<double> trace(load.begin(), load.begin() + buffer);
+        vector<int> m(buffer), t(buffer);
+
+        vector<int> ref;
+        double s_rate = rate(samples, buffer, [&]() { ref = scalar_offline_lb(trace); });
+        double k_rate = rate(samples, buffer, [&]() { kernels::provision(trace.data(), buffer, threshold, num_servers, 1, m.data()); });
+        printf("%-12zu %-18s %14.3e %14.3e %8s\n", samples, "offline_lb", s_rate, k_rate, ref == m ? "yes" : "NO");
+
+        s_rate = rate(samples, buffer, [&]() { ref = scalar_offline_lb2(trace); });
+        k_rate = rate(samples, buffer, [&]() { kernels::provision_transitions(trace.data(), buffer, threshold, num_servers, 1, m.data(), t.data()); });
+        bool same = equal(ref.begin(), ref.end(), t.begin()) && ref.size() == buffer - 1;
+        printf("%-12zu %-18s %14.3e %14.3e %8s\n", samples, "offline_lb2", s_rate, k_rate, same ? "yes" : "NO");
+
+        s_rate = rate(samples, buffer, [&]() { ref = scalar_opt(trace); });
+        k_rate = rate(samples, buffer, [&]() { kernels::provision(trace.data(), buffer, threshold, num_servers, 0, m.data()); });
+        printf("%-12zu %-18s %14.3e %14.3e %8s\n", samples, "opt_loadbalancer", s_rate, k_rate, ref == m ? "yes" : "NO");
+    }
+
+    return 0;
+}
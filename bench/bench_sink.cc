@@ -0,0 +1,99 @@
+/*
+ * Result sink benchmark
+ *
+ * writes the same series of live server counts with the export_data()
+ * main used to have (append, endl per value) and with sink.h in text and
+ * binary, with and without the background writer, and checks every file
+ * reads back the same
+ *
+ *   g++ -O2 -std=c++17 -pthread -Ilib bench/bench_sink.cc -o bench_sink
+ *   ./bench_sink [entries, default 1e8] [directory, default /tmp]
+ *
+ * author: Thato Semoko
+ */
+
+#include "sink.h"
+#include "synthetic.h"
+#include "kernels.h"
+
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+
+using namespace std;
+
+// the writer as it was before sink.h
+void legacy_export_data(string filename, vector<int> live_servers)
+{
+    ofstream out(filename.c_str(), ios_base::app);
+    for(int server: live_servers)
+    {
+        out << server << endl;
+    }
+    out.close();
+}
+
+vector<int> read_text(const string &filename)
+{
+    vector<int> values;
+    FILE *f = fopen(filename.c_str(), "r");
+    if(f == NULL) { return values; }
+    int v;
+    while(fscanf(f, "%d", &v) == 1) { values.push_back(v); }
+    fclose(f);
+    return values;
+}
+
+double seconds_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    size_t n   = argc > 1 ? size_t(atof(argv[1])) : size_t(1e8);
+    string dir = argc > 2 ? argv[2] : "/tmp";
+
+    // live servers of a 2000 server fleet over a diurnal trace
+    vector<double> load = synthetic::Generator(synthetic::DIURNAL, 1).take(n);
+    vector<int> servers(n);
+    kernels::provision(load.data(), n, 0.75, 2000, 1, servers.data());
+    vector<double>().swap(load);
+
+    string legacy = dir + "/bench_sink_legacy.txt";
+    string text   = dir + "/bench_sink.txt";
+    string binary = dir + "/bench_sink.bin";
+    remove(legacy.c_str());
+
+    printf("%zu entries\n%-24s %10s %10s %8s\n", n, "writer", "seconds", "speedup", "same");
+
+    auto start = chrono::steady_clock::now();
+    legacy_export_data(legacy, servers);
+    double base = seconds_since(start);
+    printf("%-24s %10.3f %10.2f %8s\n", "export_data (endl)", base, 1.0, read_text(legacy) == servers ? "yes" : "NO");
+    remove(legacy.c_str());
+
+    struct { const char *name; sink::Encoding encoding; bool async; } runs[] = {
+        {"sink text", sink::TEXT, false},
+        {"sink text async", sink::TEXT, true},
+        {"sink binary", sink::BINARY, false},
+        {"sink binary async", sink::BINARY, true},
+    };
+
+    for(auto &run: runs)
+    {
+        string filename = run.encoding == sink::BINARY ? binary : text;
+
+        start = chrono::steady_clock::now();
+        bool ok = sink::write_file(filename, servers, run.encoding, run.async);
+        double t = seconds_since(start);
+
+        bool same = ok && (run.encoding == sink::BINARY ? sink::read_binary(filename) : read_text(filename)) == servers;
+        printf("%-24s %10.3f %10.2f %8s\n", run.name, t, base/t, same ? "yes" : "NO");
+        remove(filename.c_str());
+    }
+
+    return 0;
+}
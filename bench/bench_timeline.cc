@@ -0,0 +1,98 @@
+/*
+ * Decision timeline benchmark
+ *
+ * provisions synthetic traces with offline_lb's rule and the optimal
+ * solver, keeps each schedule as a vector<int> and as a run-length
+ * timeline, checks that random point, server-seconds and transition
+ * queries agree, and prints memory and query speed of both
+ *
+ *   g++ -O2 -march=native -std=c++17 -Ilib bench/bench_timeline.cc -o bench_timeline
+ *   ./bench_timeline [samples, default 31536000 (a year)] [servers, default 2000] [queries, default 1e6]
+ *
+ * author: Thato Semoko
+ */
+
+#include "timeline.h"
+#include "kernels.h"
+#include "optimal.h"
+#include "synthetic.h"
+
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+using namespace std;
+
+const double threshold = 0.75;
+
+struct Query
+{
+    uint64_t a, b;
+};
+
+int main(int argc, char *argv[])
+{
+    size_t n      = argc > 1 ? size_t(atof(argv[1])) : size_t(31536000);
+    int servers   = argc > 2 ? atoi(argv[2]) : 2000;
+    size_t q      = argc > 3 ? size_t(atof(argv[3])) : size_t(1e6);
+    // windows of up to a day, the span analysis asks about
+    const uint64_t span = 86400;
+
+    printf("%zu samples, %d servers, %zu queries of up to %llus\n", n, servers, q, (unsigned long long)span);
+    printf("%-12s %-8s %10s %12s %12s %8s %14s %14s %s\n", "shape", "schedule", "runs", "vector MB", "timeline MB",
+           "ratio", "vector q/s", "timeline q/s", "check");
+
+    mt19937_64 rng(7);
+    vector<Query> queries(q);
+    for(Query &x: queries)
+    {
+        x.a = rng() % n;
+        x.b = min<uint64_t>(n, x.a + rng() % span + 1);
+    }
+
+    synthetic::Shape shapes[] = {synthetic::DIURNAL, synthetic::BURSTY, synthetic::FLASH_CROWD};
+    vector<double> load(n);
+    vector<int> m(n);
+    for(synthetic::Shape shape: shapes)
+    {
+        synthetic::Generator(shape, 1).fill(load.data(), n);
+
+        for(int schedule=0; schedule<2; schedule++)
+        {
+            if(schedule == 0) { kernels::provision(load.data(), n, threshold, servers, 1, m.data()); }
+            else { m = optimal::solve(load, threshold, servers, 100, 1).servers; }
+
+            timeline::Timeline t = timeline::build(m, servers);
+
+            // the same queries answered by scanning the vector
+            auto start = chrono::steady_clock::now();
+            uint64_t vsum = 0;
+            for(const Query &x: queries)
+            {
+                uint64_t s = 0, c = 0;
+                for(uint64_t i=x.a; i<x.b; i++)
+                {
+                    s += m[i];
+                    if(i > x.a) { c += abs(m[i] - m[i-1]); }
+                }
+                vsum += s + c + m[x.a];
+            }
+            double tv = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            start = chrono::steady_clock::now();
+            uint64_t tsum = 0;
+            for(const Query &x: queries) { tsum += t.server_seconds(x.a, x.b) + t.transitions(x.a, x.b) + t.at(x.a); }
+            double tt = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            bool same = vsum == tsum && t.expand() == m;
+            double vmb = n*sizeof(int)/1048576.0, tmb = t.bytes()/1048576.0;
+            char runs[32];
+            if(t.is_dense()) { snprintf(runs, sizeof(runs), "dense"); }
+            else { snprintf(runs, sizeof(runs), "%zu", t.runs()); }
+            printf("%-12s %-8s %10s %12.1f %12.3f %7.0fx %14.3e %14.3e %s\n", synthetic::shape_name(shape),
+                   schedule == 0 ? "offline" : "optimal", runs, vmb, tmb, vmb/tmb, q/tv, q/tt, same ? "ok" : "MISMATCH");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Topology build benchmark
+ *
+ * builds the CDN for a range of cluster and server counts, each in its own
+ * process so peak RSS is per size, and prints build time and RSS next to
+ * what topology::plan() predicted. an ns-3 program: copy it to scratch/
+ * with lib/ on the include path and
+ *
+ *   ./waf --run "bench_topology --maxClusters=2048 --maxServers=64"
+ *
+ * author: Thato Semoko
+ */
+
+#include "network.h"
+
+#include <chrono>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+using namespace std;
+using namespace ns3;
+
+struct Sample
+{
+    double seconds;
+    double rss_mb;
+};
+
+Sample build_in_child(int servers, int clusters)
+{
+    int fds[2];
+    Sample sample = {-1, -1};
+    if(pipe(fds) != 0) { return sample; }
+
+    pid_t pid = fork();
+    if(pid == 0)
+    {
+        close(fds[0]);
+        auto start = chrono::steady_clock::now();
+
+        Network cdn(servers, clusters, 0.75);
+        cdn.build();
+
+        Sample s;
+        s.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        s.rss_mb = usage.ru_maxrss/1024.0;
+
+        ssize_t n = write(fds[1], &s, sizeof(s));
+        _exit(n == sizeof(s) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    if(pid > 0)
+    {
+        ssize_t n = read(fds[0], &sample, sizeof(sample));
+        if(n != sizeof(sample)) { sample = {-1, -1}; }
+        waitpid(pid, nullptr, 0);
+    }
+    close(fds[0]);
+    return sample;
+}
+
+int main(int argc, char *argv[])
+{
+    int max_clusters = 1024;
+    int max_servers  = 64;
+
+    CommandLine cmd;
+    cmd.AddValue("maxClusters", "largest cluster count to build", max_clusters);
+    cmd.AddValue("maxServers", "largest servers per cluster to build", max_servers);
+    cmd.Parse(argc, argv);
+
+    // baseline RSS of a process that built nothing
+    Sample empty = build_in_child(1, 0);
+
+    printf("%8s %8s %10s %12s %10s %12s %12s\n", "clusters", "servers", "nodes", "predicted MB", "build s", "RSS MB",
+           "nodes/s");
+
+    for(int servers=8; servers<=max_servers; servers*=2)
+    {
+        for(int clusters=22; clusters<=max_clusters; clusters*=4)
+        {
+            topology::Plan plan = topology::plan(servers, clusters);
+            if(!plan.fits) { printf("%8d %8d does not fit the address plan\n", clusters, servers); continue; }
+
+            Sample s = build_in_child(servers, clusters);
+            printf("%8d %8d %10llu %12.1f %10.3f %12.1f %12.0f\n", clusters, servers, (unsigned long long)plan.nodes,
+                   plan.bytes/(1 << 20), s.seconds, s.rss_mb - empty.rss_mb, plan.nodes/s.seconds);
+        }
+    }
+
+    return 0;
+}
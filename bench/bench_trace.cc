@@ -0,0 +1,107 @@
+/*
+ * Trace loader benchmark
+ *
+ * compares the stream based loader main() used to have against the
+ * memory mapped trace::load on a synthetic per-second trace
+ *
+ *   g++ -O2 -std=c++17 -pthread -Ilib bench/bench_trace.cc -o bench_trace
+ *   ./bench_trace [size in MB, default 2048] [file, default /tmp/bench_trace.csv]
+ *
+ * author: Thato Semoko
+ */
+
+#include "trace.h"
+
+#include <vector>
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdio>
+
+using namespace std;
+
+// the loader as it was before trace.h
+vector<double> legacy_load_data(string filename)
+{
+    int capacity = 0.75*20000*32;
+
+    ifstream in_file(filename.c_str());
+    string line;
+    string data;
+
+    vector<double> load_d;
+
+    if(!in_file) { cerr << "File could not be opened!" << endl; }
+
+    while(getline(in_file, line, ','))
+    {
+        istringstream iss(line);
+        while(!iss.eof())
+        {
+            iss >> data;
+            load_d.push_back(stod(data)/capacity);
+        }
+    }
+    return load_d;
+}
+
+void write_trace(string filename, size_t bytes)
+{
+    // requests per second in the range the pcaps produce
+    mt19937_64 rng(42);
+    uniform_int_distribution<int> requests(0, 600000);
+
+    FILE *f = fopen(filename.c_str(), "w");
+    vector<char> buffer(1 << 20);
+    size_t written = 0;
+
+    while(written < bytes)
+    {
+        size_t n = 0;
+        while(n + 16 < buffer.size()) { n += sprintf(buffer.data() + n, "%d\n", requests(rng)); }
+        fwrite(buffer.data(), 1, n, f);
+        written += n;
+    }
+    fclose(f);
+}
+
+double seconds_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    size_t mb       = argc > 1 ? atol(argv[1]) : 2048;
+    string filename = argc > 2 ? argv[2] : "/tmp/bench_trace.csv";
+
+    cout << "writing " << mb << "MB synthetic trace to " << filename << endl;
+    write_trace(filename, mb << 20);
+
+    int capacity = 0.75*20000*32;
+    double size_mb = double(mb);
+
+    auto start = chrono::steady_clock::now();
+    vector<double> reference = legacy_load_data(filename);
+    double t = seconds_since(start);
+    // the stream loader repeats the last sample when the file ends in a newline
+    if(!reference.empty()) { reference.pop_back(); }
+    printf("%-24s %10zu samples %8.3fs %9.1f MB/s\n", "getline+istringstream", reference.size(), t, size_mb/t);
+
+    unsigned max_threads = thread::hardware_concurrency();
+    for(unsigned threads=1; threads<=max(1u, max_threads); threads*=2)
+    {
+        start = chrono::steady_clock::now();
+        vector<double> mapped = trace::load(filename, capacity, threads);
+        t = seconds_since(start);
+
+        string name = "mmap, " + to_string(threads) + " thread(s)";
+        printf("%-24s %10zu samples %8.3fs %9.1f MB/s %s\n", name.c_str(), mapped.size(), t, size_mb/t,
+               mapped == reference ? "identical" : "MISMATCH");
+    }
+
+    remove(filename.c_str());
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * Load traffic benchmark
+ *
+ * runs the same set of Load flows over a 40Gbps link once with a send event
+ * per packet and once per burst, and prints simulated seconds per wall
+ * second and events executed. an ns-3 program: copy it to scratch/ with
+ * lib/ on the include path and
+ *
+ *   ./waf --run "bench_traffic --flows=1000 --burst=16 --seconds=1"
+ *
+ * author: Thato Semoko
+ */
+
+#include "traffic.h"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace std;
+using namespace ns3;
+
+struct Result
+{
+    double wall;
+    uint64_t events;
+    uint64_t app_events;
+    uint64_t packets;
+};
+
+Result run(int flows, uint32_t burst, double seconds, string rate)
+{
+    NodeContainer nodes;
+    nodes.Create(2);
+
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("40Gbps"));
+    p2p.SetChannelAttribute("Delay", TimeValue(NanoSeconds(500)));
+    NetDeviceContainer devices = p2p.Install(nodes);
+
+    InternetStackHelper ip_stack;
+    ip_stack.Install(nodes);
+
+    Ipv4AddressHelper address;
+    address.SetBase("10.0.0.0", "255.255.255.252");
+    Ipv4InterfaceContainer interfaces = address.Assign(devices);
+
+    uint16_t port = 8080;
+    PacketSinkHelper sink("ns3::UdpSocketFactory", InetSocketAddress(Ipv4Address::GetAny(), port));
+    ApplicationContainer sink_apps = sink.Install(nodes.Get(1));
+    sink_apps.Start(Seconds(0.));
+    sink_apps.Stop(Seconds(seconds));
+
+    vector<Ptr<Load>> apps;
+    for(int i=0; i<flows; i++)
+    {
+        Ptr<Socket> socket = Socket::CreateSocket(nodes.Get(0), UdpSocketFactory::GetTypeId());
+        Ptr<Load> app = CreateObject<Load>();
+        app->setup(socket, InetSocketAddress(interfaces.GetAddress(1), port), 1000, UINT32_MAX, DataRate(rate), burst);
+        nodes.Get(0)->AddApplication(app);
+        app->SetStartTime(Seconds(0.));
+        app->SetStopTime(Seconds(seconds));
+        apps.push_back(app);
+    }
+
+    auto start = chrono::steady_clock::now();
+    Simulator::Stop(Seconds(seconds));
+    Simulator::Run();
+
+    Result r;
+    r.wall       = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    r.events     = Simulator::GetEventCount();
+    r.app_events = 0;
+    r.packets    = 0;
+    for(Ptr<Load> app: apps)
+    {
+        r.app_events += app->get_events();
+        r.packets    += app->get_packets_sent();
+    }
+
+    Simulator::Destroy();
+    return r;
+}
+
+int main(int argc, char *argv[])
+{
+    int flows = 100;
+    uint32_t burst = 16;
+    double seconds = 1.0;
+    string rate = "100Mbps";
+
+    CommandLine cmd;
+    cmd.AddValue("flows", "Load applications on the link", flows);
+    cmd.AddValue("burst", "packets per event in burst mode", burst);
+    cmd.AddValue("seconds", "simulated seconds per run", seconds);
+    cmd.AddValue("rate", "data rate of each flow", rate);
+    cmd.Parse(argc, argv);
+
+    printf("%-12s %10s %14s %14s %12s %14s\n", "mode", "wall s", "sim s/wall s", "events", "Load events", "packets");
+
+    Result per_packet = run(flows, 1, seconds, rate);
+    printf("%-12s %10.3f %14.4f %14llu %12llu %14llu\n", "per-packet", per_packet.wall, seconds/per_packet.wall,
+           (unsigned long long)per_packet.events, (unsigned long long)per_packet.app_events,
+           (unsigned long long)per_packet.packets);
+
+    Result bursts = run(flows, burst, seconds, rate);
+    printf("%-12s %10.3f %14.4f %14llu %12llu %14llu\n", ("burst " + to_string(burst)).c_str(), bursts.wall,
+           seconds/bursts.wall, (unsigned long long)bursts.events, (unsigned long long)bursts.app_events,
+           (unsigned long long)bursts.packets);
+
+    printf("speedup %.2fx, %.1f%% of the events\n", per_packet.wall/bursts.wall, 100.0*bursts.events/per_packet.events);
+    return 0;
+}
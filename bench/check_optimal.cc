@@ -0,0 +1,107 @@
+/*
+ * Optimal schedule check
+ *
+ * compares optimal::solve against a brute-force dynamic program over every
+ * x_t in [d_t, M], O(T*M^2), on random small instances and on a flat load,
+ * and against offline_lb2 wherever offline_lb is already optimal. exits
+ * non-zero on the first disagreement
+ *
+ *   g++ -O2 -std=c++17 -Ilib bench/check_optimal.cc -o check_optimal
+ *   ./check_optimal [instances, default 20000]
+ *
+ * author: Thato Semoko
+ */
+
+#include "optimal.h"
+#include "kernels.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include <cstdio>
+
+using namespace std;
+
+// least e*sum(x_t) + k*sum_(t>0)|x_t - x_(t-1)| with demand[t] <= x_t <= servers
+double brute_force(const vector<int> &demand, int servers, double k, double e)
+{
+    const double inf = 1e300;
+    vector<double> cost(servers + 1, inf), next(servers + 1);
+    for(int x=demand[0]; x<=servers; x++) { cost[x] = e*x; }
+
+    for(size_t t=1; t<demand.size(); t++)
+    {
+        for(int x=0; x<=servers; x++)
+        {
+            next[x] = inf;
+            if(x < demand[t]) { continue; }
+            for(int y=0; y<=servers; y++)
+            {
+                if(cost[y] < inf) { next[x] = min(next[x], cost[y] + k*abs(x - y) + e*x); }
+            }
+        }
+        cost.swap(next);
+    }
+
+    double best = inf;
+    for(double c: cost) { best = min(best, c); }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    int instances = argc > 1 ? atoi(argv[1]) : 20000;
+    const double threshold = 0.75;
+
+    // a flat load needs no transitions, optimal must not cost more than offline_lb
+    {
+        vector<double> flat(1000, 0.6);
+        optimal::Schedule s = optimal::solve(flat, threshold, 32, 100);
+        vector<int> m(flat.size());
+        kernels::provision(flat.data(), flat.size(), threshold, 32, 1, m.data());
+        uint64_t greedy = 0;
+        for(int x: m) { greedy += x; }
+        if(s.transitions != 0 || s.server_seconds != greedy)
+        {
+            printf("flat load: %llu server-seconds %llu transitions, offline_lb %llu server-seconds\n",
+                   (unsigned long long)s.server_seconds, (unsigned long long)s.transitions, (unsigned long long)greedy);
+            return 1;
+        }
+    }
+
+    mt19937_64 rng(11);
+    for(int i=0; i<instances; i++)
+    {
+        int T       = 1 + rng() % 40;
+        int servers = 1 + rng() % 8;
+        double k    = (rng() % 60)/4.0;
+        double e    = 0.25 + (rng() % 12)/4.0;
+
+        vector<double> load(T);
+        for(double &l: load) { l = (rng() % 1000)/1000.0*threshold*1.2; }
+
+        optimal::Schedule s = optimal::solve(load, threshold, servers, k, e);
+
+        vector<int> demand(T);
+        kernels::provision(load.data(), T, threshold, servers, 1, demand.data());
+        for(int t=0; t<T; t++)
+        {
+            if(s.servers[t] < demand[t] || s.servers[t] > servers)
+            {
+                printf("instance %d: x_%d = %d outside [%d, %d]\n", i, t, s.servers[t], demand[t], servers);
+                return 1;
+            }
+        }
+
+        double best = brute_force(demand, servers, k, e);
+        if(fabs(s.total - best) > 1e-6*max(1.0, best))
+        {
+            printf("instance %d: T %d, M %d, k %g, e %g: solve %.6f, brute force %.6f\n", i, T, servers, k, e, s.total,
+                   best);
+            return 1;
+        }
+    }
+
+    printf("%d instances agree with the brute force, flat load costs the same as offline_lb\n", instances);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#!/bin/sh
+#
+# MPI speedup of the packet-level simulation
+#
+# times the replay of the same trace window sequentially and split over
+# 2, 4 and 8 ranks for 22, 88 and 352 clusters, and prints the speedup of
+# each run over the sequential one. needs ns-3 configured with --enable-mpi
+# and src/main.cc copied to scratch/ as main; run from the ns-3 directory
+#
+#   TRACE=trace.bin FROM=0 TO=1 sh bench/mpi_speedup.sh
+#
+# author: Thato Semoko
+
+TRACE=${TRACE:-./test_pcaps/data_new.csv}
+FROM=${FROM:--1}
+TO=${TO:--1}
+RANKS=${RANKS:-"2 4 8"}
+CLUSTERS=${CLUSTERS:-"22 88 352"}
+ARGS="--trace=$TRACE --from=$FROM --to=$TO --simulate=1"
+
+./waf build > /dev/null || exit 1
+PROGRAM=$(./waf --run main --command-template="echo %s" | tail -n 1)
+
+# the slowest rank's simulation time, ranks finish together so it is the run's
+sim_time()
+{
+    grep "^rank " | sed 's/.*simulation \([0-9.e+-]*\)s.*/\1/' | sort -g | tail -n 1
+}
+
+printf "%-10s %-6s %12s %10s\n" "clusters" "ranks" "sim wall s" "speedup"
+for c in $CLUSTERS
+do
+    seq=$($PROGRAM $ARGS --clusters=$c | sim_time)
+    printf "%-10s %-6s %12s %10s\n" "$c" "1" "$seq" "1.00"
+
+    for n in $RANKS
+    do
+        t=$(mpirun -np $n $PROGRAM $ARGS --clusters=$c --distributed=1 | sim_time)
+        printf "%-10s %-6s %12s %10.2f\n" "$c" "$n" "$t" "$(echo "$seq / $t" | bc -l)"
+    done
+done
@@ -0,0 +1,38 @@
+#!/bin/sh
+#
+# telemetry overhead on simulation speed
+#
+# replays the same trace window without telemetry, with CSV records and
+# with binary records, and prints the simulation wall time of each and its
+# slowdown over the plain run. src/main.cc must be in scratch/ as main; run
+# from the ns-3 directory
+#
+#   TRACE=trace.bin FROM=0 TO=1 CLUSTERS=88 sh bench/telemetry_overhead.sh
+#
+# author: Thato Semoko
+
+TRACE=${TRACE:-./test_pcaps/data_new.csv}
+FROM=${FROM:--1}
+TO=${TO:--1}
+CLUSTERS=${CLUSTERS:-22}
+INTERVAL=${INTERVAL:-1}
+ARGS="--trace=$TRACE --from=$FROM --to=$TO --simulate=1 --clusters=$CLUSTERS --interval=$INTERVAL"
+
+./waf build > /dev/null || exit 1
+PROGRAM=$(./waf --run main --command-template="echo %s" | tail -n 1)
+
+sim_time()
+{
+    grep "^rank " | sed 's/.*simulation \([0-9.e+-]*\)s.*/\1/' | tail -n 1
+}
+
+base=$($PROGRAM $ARGS | sim_time)
+printf "%-10s %12s %10s\n" "telemetry" "sim wall s" "overhead"
+printf "%-10s %12s %9.1f%%\n" "off" "$base" 0
+
+for kind in csv bin
+do
+    t=$($PROGRAM $ARGS --telemetry=/tmp/telemetry_overhead.$kind | sim_time)
+    printf "%-10s %12s %9.1f%%\n" "$kind" "$t" "$(echo "($t / $base - 1)*100" | bc -l)"
+    rm -f /tmp/telemetry_overhead.$kind
+done
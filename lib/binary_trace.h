@@ -0,0 +1,240 @@
+/*
+ * Binary trace header file
+ *
+ * columnar on-disk trace: a fixed header, a uint32 time column (seconds
+ * since t0), a load column (double or uint16 fractions) and a sparse
+ * index holding every index_stride-th time for windowed access
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef BINARY_TRACE_H
+#define BINARY_TRACE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <iostream>
+
+#include "trace.h"
+
+using namespace std;
+
+namespace trace
+{
+    enum LoadEncoding : uint32_t
+    {
+        LOAD_F64 = 0,   // exact, 8 bytes per sample
+        LOAD_U16 = 1    // load = q*scale, 2 bytes per sample
+    };
+
+    struct BinaryHeader
+    {
+        char     magic[8];      // "ELBTRACE"
+        uint32_t version;
+        uint32_t encoding;
+        uint64_t samples;
+        int64_t  t0;            // first timestamp (s)
+        double   capacity;      // requests/s that map to a load of 1
+        double   scale;         // LOAD_U16 only
+        uint64_t time_offset;
+        uint64_t load_offset;
+        uint64_t index_offset;
+        uint32_t index_stride;
+        uint32_t reserved;
+    };
+
+    static const char BINARY_MAGIC[8] = {'E','L','B','T','R','A','C','E'};
+    static const uint32_t BINARY_VERSION = 1;
+
+    // true if the file starts with the binary trace magic
+    inline bool is_binary(const string &filename)
+    {
+        char magic[8];
+        FILE *f = fopen(filename.c_str(), "rb");
+        if(!f) { return false; }
+        size_t n = fread(magic, 1, sizeof(magic), f);
+        fclose(f);
+        return n == sizeof(magic) && memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+    }
+
+    inline uint64_t align8(uint64_t offset) { return (offset + 7) & ~uint64_t(7); }
+
+    /*
+     * write normalised load with absolute timestamps (seconds, ascending).
+     * returns false if the file could not be written
+     */
+    inline bool write_binary(const string &filename, const vector<int64_t> &times, const vector<double> &load,
+                             double capacity, LoadEncoding encoding, uint32_t index_stride = 4096)
+    {
+        BinaryHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, BINARY_MAGIC, sizeof(h.magic));
+        h.version      = BINARY_VERSION;
+        h.encoding     = encoding;
+        h.samples      = load.size();
+        h.t0           = times.empty() ? 0 : times[0];
+        h.capacity     = capacity;
+        h.index_stride = index_stride;
+
+        size_t load_width = encoding == LOAD_U16 ? sizeof(uint16_t) : sizeof(double);
+        uint64_t entries  = (h.samples + index_stride - 1)/index_stride;
+
+        h.time_offset  = align8(sizeof(BinaryHeader));
+        h.load_offset  = align8(h.time_offset + h.samples*sizeof(uint32_t));
+        h.index_offset = align8(h.load_offset + h.samples*load_width);
+
+        double peak = 0;
+        for(double l: load) { peak = max(peak, l); }
+        h.scale = peak > 0 ? peak/65535.0 : 1.0;
+
+        FILE *f = fopen(filename.c_str(), "wb");
+        if(!f) { cerr << "File could not be opened!" << endl; return false; }
+
+        const char zeros[8] = {0};
+        auto pad_to = [&](uint64_t offset) { fwrite(zeros, 1, offset - ftell(f), f); };
+
+        fwrite(&h, sizeof(h), 1, f);
+
+        // columns are written in blocks to keep the converter's memory flat
+        const size_t block = 1 << 16;
+        vector<uint32_t> t_col;
+        vector<uint16_t> q_col;
+
+        pad_to(h.time_offset);
+        for(size_t i=0; i<h.samples; i+=block)
+        {
+            size_t n = min(block, size_t(h.samples - i));
+            t_col.resize(n);
+            for(size_t j=0; j<n; j++) { t_col[j] = uint32_t(times[i+j] - h.t0); }
+            fwrite(t_col.data(), sizeof(uint32_t), n, f);
+        }
+
+        pad_to(h.load_offset);
+        if(encoding == LOAD_U16)
+        {
+            for(size_t i=0; i<h.samples; i+=block)
+            {
+                size_t n = min(block, size_t(h.samples - i));
+                q_col.resize(n);
+                for(size_t j=0; j<n; j++) { q_col[j] = uint16_t(lround(max(0.0, load[i+j])/h.scale)); }
+                fwrite(q_col.data(), sizeof(uint16_t), n, f);
+            }
+        }
+        else { fwrite(load.data(), sizeof(double), h.samples, f); }
+
+        pad_to(h.index_offset);
+        for(uint64_t e=0; e<entries; e++)
+        {
+            uint32_t t = uint32_t(times[e*index_stride] - h.t0);
+            fwrite(&t, sizeof(t), 1, f);
+        }
+
+        bool ok = !ferror(f);
+        fclose(f);
+        return ok;
+    }
+
+    /*
+     * memory mapped reader, columns are used in place
+     */
+    class BinaryTrace
+    {
+        private:
+            MappedFile file;
+            const BinaryHeader *header;
+            const uint32_t *time_col;
+            const uint32_t *index_col;
+            const double   *f64_col;
+            const uint16_t *u16_col;
+            uint64_t entries;
+
+        public:
+            BinaryTrace(const string &filename) : file(filename), header(nullptr), time_col(nullptr),
+                                                  index_col(nullptr), f64_col(nullptr), u16_col(nullptr), entries(0)
+            {
+                if(!this->file.valid() || this->file.size() < sizeof(BinaryHeader)) { return; }
+
+                const BinaryHeader *h = reinterpret_cast<const BinaryHeader *>(this->file.data());
+                if(memcmp(h->magic, BINARY_MAGIC, sizeof(h->magic)) != 0 || h->version != BINARY_VERSION) { return; }
+                if(h->index_stride == 0) { return; }
+
+                uint64_t entries = (h->samples + h->index_stride - 1)/h->index_stride;
+                if(h->index_offset + entries*sizeof(uint32_t) > this->file.size()) { return; }
+
+                this->header    = h;
+                this->entries   = entries;
+                this->time_col  = reinterpret_cast<const uint32_t *>(this->file.data() + h->time_offset);
+                this->index_col = reinterpret_cast<const uint32_t *>(this->file.data() + h->index_offset);
+
+                if(h->encoding == LOAD_U16) { this->u16_col = reinterpret_cast<const uint16_t *>(this->file.data() + h->load_offset); }
+                else { this->f64_col = reinterpret_cast<const double *>(this->file.data() + h->load_offset); }
+            }
+
+            bool valid(void) const { return this->header != nullptr; }
+            size_t size(void) const { return this->header ? this->header->samples : 0; }
+            int64_t t0(void) const { return this->header->t0; }
+            double capacity(void) const { return this->header->capacity; }
+            LoadEncoding encoding(void) const { return LoadEncoding(this->header->encoding); }
+
+            int64_t time(size_t i) const { return this->header->t0 + this->time_col[i]; }
+
+            double load(size_t i) const
+            {
+                if(this->u16_col) { return this->u16_col[i]*this->header->scale; }
+                return this->f64_col[i];
+            }
+
+            /*
+             * index of the first sample with time >= t: binary search over
+             * the sparse index, then over at most index_stride times
+             */
+            size_t lower_bound(int64_t t) const
+            {
+                if(t <= this->header->t0) { return 0; }
+                if(t - this->header->t0 > int64_t(UINT32_MAX)) { return this->size(); }
+                uint32_t rel = uint32_t(t - this->header->t0);
+
+                const uint32_t *e = std::upper_bound(this->index_col, this->index_col + this->entries, rel);
+                size_t block = e == this->index_col ? 0 : (e - this->index_col) - 1;
+
+                size_t first = block*this->header->index_stride;
+                size_t last  = min(first + this->header->index_stride, this->size());
+                return std::lower_bound(this->time_col + first, this->time_col + last, rel) - this->time_col;
+            }
+
+            // decode the samples in [begin, end) seconds
+            vector<double> window(int64_t begin, int64_t end) const
+            {
+                size_t first = this->lower_bound(begin);
+                size_t last  = this->lower_bound(end);
+
+                vector<double> out(last > first ? last - first : 0);
+                for(size_t i=first; i<last; i++) { out[i-first] = this->load(i); }
+                return out;
+            }
+
+            vector<double> all(void) const
+            {
+                vector<double> out(this->size());
+                for(size_t i=0; i<out.size(); i++) { out[i] = this->load(i); }
+                return out;
+            }
+    };
+
+    // load either format, the binary one is already normalised
+    inline vector<double> load_any(const string &filename, double capacity, unsigned threads = 1)
+    {
+        if(!is_binary(filename)) { return load(filename, capacity, threads); }
+
+        BinaryTrace bin(filename);
+        if(!bin.valid()) { cerr << "Invalid binary trace!" << endl; return vector<double>(); }
+        return bin.all();
+    }
+};
+#endif
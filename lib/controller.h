@@ -0,0 +1,233 @@
+/*
+ * In-simulation balancer header file
+ *
+ * the online balancer as an application on the origin node. demand is
+ * counted from the origin's links to the clusters through their MacTx
+ * trace sources, nothing is polled; every control interval the bytes
+ * seen are turned into a load sample, the online engine decides m_t, and
+ * in every cluster the first m_t hosts have their interfaces up and the
+ * rest down. the decision time of each tick and, for every spike where
+ * demand outran the live servers, the simulated time until enough
+ * servers were live again are kept as histograms
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+#include <memory>
+#include <iostream>
+
+#include "network.h"
+#include "replay.h"
+#include "online.h"
+#include "instrument.h"
+
+using namespace ns3;
+using namespace std;
+
+struct ControllerStats
+{
+    uint64_t ticks;
+    uint64_t switched;          // interfaces brought up or down
+    uint64_t spikes;            // demand above live capacity, each counted once
+};
+
+class BalancerApp : public Application
+{
+    private:
+        // a rack host the controller switches
+        struct Host
+        {
+            Ptr<Ipv4> ipv4;
+            int32_t interface;
+            Server *rack;
+            bool up;
+        };
+
+        Network *cdn;
+        TraceReplayer *replayer;        // told which hosts are live, may be null
+        Time interval;
+        double peak_bps;                // link rate of the CDN at a load of 1
+        double kappa;
+        int tau;
+
+        unique_ptr<online::OnlineBalancer> engine;  // made by install()
+        vector<vector<Host>> hosts;     // per cluster, in replay flow order
+        vector<uint8_t> live;           // per flow, for the replayer
+        uint64_t bytes;                 // sent towards the clusters this interval
+        int capacity;                   // m_t live in every cluster
+        bool in_spike;
+        Time spike_start;
+
+        EventId tick_event;
+        instrument::Histogram overhead;     // wall ns per tick
+        instrument::Histogram reaction;     // simulated ns per spike
+        ControllerStats stats;
+
+        void on_tx(Ptr<const Packet> packet) { this->bytes += packet->GetSize(); }
+
+        // interfaces of the first m hosts of every cluster up, the rest down
+        void apply(int m)
+        {
+            size_t flow = 0;
+            for(vector<Host> &cluster: this->hosts)
+            {
+                for(size_t k=0; k<cluster.size(); k++, flow++)
+                {
+                    Host &h = cluster[k];
+                    bool up = int(k) < m;
+                    this->live[flow] = up;
+                    if(up == h.up) { continue; }
+
+                    if(up) { h.ipv4->SetUp(h.interface); }
+                    else { h.ipv4->SetDown(h.interface); }
+                    h.up = up;
+                    this->stats.switched++;
+                }
+
+                // a rack is on while any of its hosts is, a rack's hosts are adjacent
+                Server *rack = NULL;
+                bool on = false;
+                for(Host &h: cluster)
+                {
+                    if(h.rack != rack)
+                    {
+                        if(rack) { rack->setState(on ? SERVER_ON : SERVER_OFF); }
+                        rack = h.rack;
+                        on = false;
+                    }
+                    on = on || h.up;
+                }
+                if(rack) { rack->setState(on ? SERVER_ON : SERVER_OFF); }
+            }
+            if(this->replayer) { this->replayer->set_live(this->live); }
+        }
+
+        void tick(void)
+        {
+            uint64_t start = instrument::now_ns();
+
+            double load = this->bytes*8.0/this->interval.GetSeconds()/this->peak_bps;
+            this->bytes = 0;
+
+            // what the servers live through the interval could carry
+            double live_capacity = this->capacity*this->cdn->get_threshold()/this->cdn->get_servers();
+            if(load > live_capacity && !this->in_spike)
+            {
+                this->in_spike = true;
+                this->spike_start = Simulator::Now() - this->interval;
+                this->stats.spikes++;
+            }
+
+            online::Decision d = this->engine->push(load);
+            if(d.live != this->capacity)
+            {
+                this->capacity = d.live;
+                this->apply(d.live);
+            }
+
+            if(this->in_spike && this->capacity*this->cdn->get_threshold()/this->cdn->get_servers() >= load)
+            {
+                this->reaction.record(uint64_t((Simulator::Now() - this->spike_start).GetNanoSeconds()));
+                this->in_spike = false;
+            }
+
+            this->stats.ticks++;
+            this->overhead.record(instrument::now_ns() - start);
+            this->tick_event = Simulator::Schedule(this->interval, &BalancerApp::tick, this);
+        }
+
+        void StartApplication(void)
+        {
+            this->bytes = 0;
+            this->tick_event = Simulator::Schedule(this->interval, &BalancerApp::tick, this);
+        }
+
+        void StopApplication(void)
+        {
+            if(this->tick_event.IsRunning()) { Simulator::Cancel(this->tick_event); }
+        }
+
+    public:
+        BalancerApp() : cdn(NULL), replayer(NULL), interval(Seconds(1)), peak_bps(1), kappa(0.25), tau(60), bytes(0),
+                        capacity(0), in_spike(false)
+        {
+            this->stats = ControllerStats{0, 0, 0};
+        }
+
+        ~BalancerApp() {}
+
+        /*
+         * control interval, rate of the CDN at a load of 1 (the replay
+         * peak) and the online engine's kappa and tau (seconds, rounded to
+         * whole intervals)
+         */
+        void setup(Network *cdn, Time interval, DataRate peak, double kappa, int tau, TraceReplayer *replayer = NULL)
+        {
+            this->cdn      = cdn;
+            this->interval = interval;
+            this->peak_bps = double(peak.GetBitRate());
+            this->kappa    = kappa;
+            this->tau      = tau;
+            this->replayer = replayer;
+        }
+
+        /*
+         * add the application to the origin and hook its links. the whole
+         * topology must be in this process, switching remote hosts is not
+         * possible in a distributed run
+         */
+        void install(void)
+        {
+            Ptr<Node> origin = this->cdn->get_origin();
+            origin->AddApplication(this);
+
+            for(const NetDeviceContainer &link: this->cdn->getNetDevs())
+            {
+                link.Get(0)->TraceConnectWithoutContext("MacTx", MakeCallback(&BalancerApp::on_tx, this));
+            }
+
+            int tau_ticks = max(1, int(this->tau/this->interval.GetSeconds() + 0.5));
+            this->engine.reset(new online::OnlineBalancer(this->cdn->get_servers(), this->cdn->get_threshold(),
+                                                          this->kappa, tau_ticks));
+
+            // hosts of each cluster in the order the replayer made its flows
+            size_t flows = 0;
+            this->hosts.assign(this->cdn->get_clusters(), vector<Host>());
+            for(Server *rack: this->cdn->get_server_nodes())
+            {
+                for(uint32_t i=1; i<rack->getNodes().GetN(); i++)
+                {
+                    Ptr<Ipv4> ipv4 = rack->getNodes().Get(i)->GetObject<Ipv4>();
+                    Host h = {ipv4, ipv4->GetInterfaceForDevice(rack->getNetDev().Get(i)), rack, true};
+                    this->hosts[rack->getClusterID()].push_back(h);
+                    flows++;
+                }
+                rack->setState(SERVER_ON);
+            }
+            this->live.assign(flows, 1);
+
+            // the engine starts with the whole fleet live
+            this->capacity = this->cdn->get_servers();
+        }
+
+        ControllerStats get_stats(void) const { return this->stats; }
+        const instrument::Histogram &get_overhead(void) const { return this->overhead; }
+        const instrument::Histogram &get_reaction(void) const { return this->reaction; }
+
+        void report(ostream &out)
+        {
+            const instrument::Histogram &o = this->overhead, &r = this->reaction;
+            out << "controller: " << this->stats.ticks << " ticks, " << this->stats.switched << " interfaces switched, "
+                << "tick overhead p50 " << o.quantile(0.5)/1e3 << "us p99 " << o.quantile(0.99)/1e3 << "us max "
+                << o.get_max()/1e3 << "us" << endl;
+            out << "controller: " << this->stats.spikes << " spikes, " << r.get_calls() << " caught up, reaction p50 "
+                << r.quantile(0.5)/1e6 << "ms p99 " << r.quantile(0.99)/1e6 << "ms max " << r.get_max()/1e6 << "ms" << endl;
+        }
+};
+#endif
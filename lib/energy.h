@@ -0,0 +1,192 @@
+/*
+ * Energy accounting header file
+ *
+ * energy and cost of a provisioning schedule, accumulated one decision at
+ * a time as the balancer makes them. a live server draws
+ *
+ *   idle + (peak - idle)*u,  u = min(1, load*servers/live)
+ *
+ * so the load is spread evenly over the live servers, off servers draw
+ * the sleep power, and every server woken costs a fixed wake-up energy.
+ * the same trace with the whole fleet live is tallied alongside as the
+ * baseline the savings are measured against
+ *
+ * the 63W and 92W defaults are bin/data_process.py's, its formula is not.
+ * the script plots (63 + 29*load)*m_t, every live server as busy as the
+ * fleet's normalised load, so its load dependent part grows with m_t for
+ * the same traffic. here the work is fixed by the traffic and only the
+ * idle draw follows m_t, and the baseline is the whole fleet rather than
+ * the script's 17 servers. the two sets of figures do not compare
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+namespace energy
+{
+    // per server figures, watts and joules, dt seconds per sample
+    struct PowerModel
+    {
+        double idle_w;
+        double peak_w;
+        double sleep_w;
+        double wake_j;
+        double price_kwh;       // cost per kWh
+        double dt;
+
+        PowerModel() : idle_w(63), peak_w(92), sleep_w(0), wake_j(63*30), price_kwh(0.12), dt(1) {}
+    };
+
+    struct Tally
+    {
+        uint64_t samples;
+        double server_seconds;
+        uint64_t wakes, sleeps;
+        double live_j;          // idle and load dependent draw of live servers
+        double sleep_j;
+        double wake_j;
+        double energy_j;        // live + sleep + wake
+        double baseline_j;      // every server live, no transitions
+        double cost;
+
+        double saved(void) const { return this->baseline_j - this->energy_j; }
+    };
+
+    // a window of samples starting at begin
+    struct Window
+    {
+        uint64_t begin;
+        Tally tally;
+    };
+
+    class Meter
+    {
+        private:
+            PowerModel model;
+            int servers;
+            uint64_t window;    // samples per window, 0 for none
+            int prev;           // live servers at the previous sample, -1 before the first
+
+            Tally totals, current;
+            vector<Window> windows;
+
+            static Tally empty(void) { return Tally{0, 0, 0, 0, 0, 0, 0, 0, 0, 0}; }
+
+            static void add(Tally &t, const Tally &d)
+            {
+                t.samples += d.samples;
+                t.server_seconds += d.server_seconds;
+                t.wakes += d.wakes;
+                t.sleeps += d.sleeps;
+                t.live_j += d.live_j;
+                t.sleep_j += d.sleep_j;
+                t.wake_j += d.wake_j;
+                t.energy_j += d.energy_j;
+                t.baseline_j += d.baseline_j;
+                t.cost += d.cost;
+            }
+
+            void close_window(void)
+            {
+                add(this->totals, this->current);
+                if(this->window > 0) { this->windows.push_back(Window{this->totals.samples - this->current.samples, this->current}); }
+                this->current = empty();
+            }
+
+        public:
+            Meter(const PowerModel &model, int servers, uint64_t window = 0) :
+                model(model), servers(servers), window(window), prev(-1)
+            {
+                this->totals  = empty();
+                this->current = empty();
+            }
+
+            ~Meter() {}
+
+            // one decision: the normalised load and m_t serving it
+            void push(double load, int live)
+            {
+                const PowerModel &p = this->model;
+                double demand = max(0.0, load)*this->servers;       // fully used servers' worth of work
+                double swing  = p.peak_w - p.idle_w;
+
+                double live_w = live*p.idle_w + swing*min(double(live), demand);
+                double base_w = this->servers*p.idle_w + swing*min(double(this->servers), demand);
+                double sleep_w = (this->servers - live)*p.sleep_w;
+
+                int woken = this->prev < 0 ? 0 : max(0, live - this->prev);
+                int slept = this->prev < 0 ? 0 : max(0, this->prev - live);
+                this->prev = live;
+
+                Tally &t = this->current;
+                t.samples++;
+                t.server_seconds += live*p.dt;
+                t.wakes  += woken;
+                t.sleeps += slept;
+                t.live_j  += live_w*p.dt;
+                t.sleep_j += sleep_w*p.dt;
+                t.wake_j  += woken*p.wake_j;
+
+                double step_j = live_w*p.dt + sleep_w*p.dt + woken*p.wake_j;
+                t.energy_j   += step_j;
+                t.baseline_j += base_w*p.dt;
+                t.cost       += step_j/3.6e6*p.price_kwh;
+
+                if(this->window > 0 && t.samples == this->window) { this->close_window(); }
+            }
+
+            void push(const double *load, const int *live, size_t n)
+            {
+                for(size_t i=0; i<n; i++) { this->push(load[i], live[i]); }
+            }
+
+            // totals so far, including the window still open
+            Tally get_totals(void) const
+            {
+                Tally t = this->totals;
+                add(t, this->current);
+                return t;
+            }
+
+            // the closed windows, call finish() to close the last partial one
+            const vector<Window> &get_windows(void) const { return this->windows; }
+
+            void finish(void)
+            {
+                if(this->current.samples > 0) { this->close_window(); }
+            }
+
+            const PowerModel &get_model(void) const { return this->model; }
+
+            // one line per window, energies in kWh
+            bool write_csv(const string &filename) const
+            {
+                FILE *f = fopen(filename.c_str(), "w");
+                if(f == NULL) { return false; }
+
+                fprintf(f, "begin,samples,server_seconds,wakes,sleeps,live_kwh,sleep_kwh,wake_kwh,energy_kwh,"
+                           "baseline_kwh,cost\n");
+                for(const Window &w: this->windows)
+                {
+                    const Tally &t = w.tally;
+                    fprintf(f, "%llu,%llu,%.0f,%llu,%llu,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n", (unsigned long long)w.begin,
+                            (unsigned long long)t.samples, t.server_seconds, (unsigned long long)t.wakes,
+                            (unsigned long long)t.sleeps, t.live_j/3.6e6, t.sleep_j/3.6e6, t.wake_j/3.6e6,
+                            t.energy_j/3.6e6, t.baseline_j/3.6e6, t.cost);
+                }
+                return fclose(f) == 0;
+            }
+    };
+};
+#endif
@@ -0,0 +1,196 @@
+/*
+ * Ensemble header file
+ *
+ * independent replications of one scenario, one process each. the
+ * simulator is single threaded, so the only way to use more cores is
+ * more processes: spawn() forks up to jobs children at a time and returns
+ * in each child with its replication number, the child runs the scenario
+ * with its own seed and writes a fixed size Metrics record to its pipe.
+ * the parent collects the records as children finish and starts the next
+ * replication in the freed slot
+ *
+ * summaries are the mean, standard deviation and the half width of a 95%
+ * confidence interval on the mean (Student's t)
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "parallel.h"
+
+using namespace std;
+
+namespace ensemble
+{
+    enum Metric
+    {
+        WALL_S,             // simulation wall time
+        SEND_EVENTS,
+        TX_PACKETS,
+        RX_PACKETS,
+        RX_BYTES,
+        LOST,
+        LOSS_RATE,          // lost over sent
+        DELAY_MS,           // mean one-way delay of received packets
+        TICKS,              // in-simulation balancer
+        SWITCHED,
+        SPIKES,
+        REACTION_P99_MS,
+        NUM_METRICS
+    };
+
+    static const char *METRIC_NAMES[NUM_METRICS] =
+    {
+        "wall_s", "send_events", "tx_packets", "rx_packets", "rx_bytes", "lost", "loss_rate", "delay_ms", "ticks",
+        "switched", "spikes", "reaction_p99_ms"
+    };
+
+    // what one replication sends back, plain data so it goes through a pipe as is
+    struct Metrics
+    {
+        uint32_t replication;
+        uint32_t run;               // RngSeedManager run number
+        uint32_t ok;
+        double value[NUM_METRICS];
+    };
+
+    struct Summary
+    {
+        uint32_t n;
+        double mean;
+        double stddev;
+        double half_width;          // 95% confidence interval is mean +- half_width
+    };
+
+    // two sided 95% quantile of Student's t with df degrees of freedom
+    inline double t95(uint32_t df)
+    {
+        static const double table[30] =
+        {
+            12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+            2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+            2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+        };
+        if(df == 0) { return 0; }
+        if(df <= 30) { return table[df - 1]; }
+        if(df <= 60) { return 2.000 + (2.042 - 2.000)*(60.0 - df)/30; }
+        if(df <= 120) { return 1.980 + (2.000 - 1.980)*(120.0 - df)/60; }
+        return 1.960;
+    }
+
+    // over the replications that reported
+    inline Summary summarize(const vector<Metrics> &runs, Metric m)
+    {
+        Summary s = {0, 0, 0, 0};
+        for(const Metrics &r: runs)
+        {
+            if(!r.ok) { continue; }
+            s.n++;
+            s.mean += r.value[m];
+        }
+        if(s.n == 0) { return s; }
+        s.mean /= s.n;
+
+        double ss = 0;
+        for(const Metrics &r: runs)
+        {
+            if(r.ok) { ss += (r.value[m] - s.mean)*(r.value[m] - s.mean); }
+        }
+        s.stddev     = s.n > 1 ? sqrt(ss/(s.n - 1)) : 0;
+        s.half_width = s.n > 1 ? t95(s.n - 1)*s.stddev/sqrt(double(s.n)) : 0;
+        return s;
+    }
+
+    /*
+     * run replications 0..n-1, at most jobs (0 for every core) at once.
+     * returns the replication number in a child, with fd the pipe to write
+     * its Metrics to; returns -1 in the parent once every child is done,
+     * results in replication order. a child that dies without reporting
+     * leaves its record with ok = 0
+     */
+    inline int spawn(uint32_t n, unsigned jobs, int &fd, vector<Metrics> &results)
+    {
+        if(jobs == 0) { jobs = parallel::default_threads(); }
+
+        results.assign(n, Metrics());
+        for(uint32_t r=0; r<n; r++) { results[r].replication = r; results[r].ok = 0; }
+
+        struct Child
+        {
+            pid_t pid;
+            int fd;
+            uint32_t replication;
+        };
+        vector<Child> running;
+
+        uint32_t next = 0;
+        while(next < n || !running.empty())
+        {
+            if(next < n && running.size() < jobs)
+            {
+                int fds[2];
+                if(pipe(fds) != 0) { next = n; continue; }
+                fflush(stdout);
+                pid_t pid = fork();
+                if(pid == 0)
+                {
+                    close(fds[0]);
+                    for(const Child &c: running) { close(c.fd); }
+                    fd = fds[1];
+                    return int(next);
+                }
+                close(fds[1]);
+                if(pid < 0) { close(fds[0]); next = n; continue; }
+                running.push_back(Child{pid, fds[0], next++});
+                continue;
+            }
+
+            // a record is far smaller than a pipe's buffer, the child never blocks on it
+            pid_t done = wait(NULL);
+            if(done < 0) { break; }
+            for(size_t i=0; i<running.size(); i++)
+            {
+                if(running[i].pid != done) { continue; }
+                Metrics m;
+                if(read(running[i].fd, &m, sizeof(m)) == ssize_t(sizeof(m)) && m.replication == running[i].replication)
+                {
+                    results[m.replication] = m;
+                }
+                close(running[i].fd);
+                running.erase(running.begin() + i);
+                break;
+            }
+        }
+        fd = -1;
+        return -1;
+    }
+
+    // one row per replication
+    inline bool write_csv(const string &filename, const vector<Metrics> &results)
+    {
+        FILE *out = fopen(filename.c_str(), "w");
+        if(!out) { return false; }
+        fprintf(out, "replication,run,ok");
+        for(int m=0; m<NUM_METRICS; m++) { fprintf(out, ",%s", METRIC_NAMES[m]); }
+        fprintf(out, "\n");
+        for(const Metrics &r: results)
+        {
+            fprintf(out, "%u,%u,%u", r.replication, r.run, r.ok);
+            for(int m=0; m<NUM_METRICS; m++) { fprintf(out, ",%.9g", r.value[m]); }
+            fprintf(out, "\n");
+        }
+        return fclose(out) == 0;
+    }
+};
+#endif
@@ -0,0 +1,31 @@
+/*
+ * Fleet header file
+ *
+ * the numbers the balancing algorithms need from the CDN, without any of
+ * the ns-3 topology behind them
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef FLEET_H
+#define FLEET_H
+
+class Fleet
+{
+    protected:
+        int num_servers, num_clusters;
+        double load_threshold;
+
+    public:
+        // default constructor
+        Fleet() : num_servers(0), num_clusters(0), load_threshold(0) {}
+
+        Fleet(int s, int c, double t) : num_servers(s), num_clusters(c), load_threshold(t) {}
+
+        ~Fleet() {}
+
+        double get_threshold() const { return this->load_threshold; }
+        int get_servers() const { return this->num_servers; }
+        int get_clusters() const { return this->num_clusters; }
+};
+#endif
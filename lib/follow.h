@@ -0,0 +1,277 @@
+/*
+ * Follow mode header file
+ *
+ * balances a trace that keeps growing without going back over what was
+ * already done. a state file holds how far into the trace the last pass
+ * got (a byte offset on a separator), offline_lb's last m_t and the
+ * online controller, and how long each output file was. a pass parses
+ * only the bytes after the offset, appends the decisions and transitions
+ * of the new samples to the outputs and replaces the state file, so its
+ * cost follows the new data, not the length of the trace
+ *
+ * a pass that died between appending and saving the state left output
+ * the state does not know about, the next pass cuts the outputs back to
+ * the recorded lengths first. a trace that got shorter, or a state made
+ * with other balancer parameters, starts over from the beginning. a
+ * trace that is missing or empty (being rotated, say) skips the pass and
+ * leaves the state and the outputs as they were
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef FOLLOW_H
+#define FOLLOW_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <sys/stat.h>
+
+#include "trace.h"
+#include "kernels.h"
+#include "online.h"
+
+using namespace std;
+
+namespace follow
+{
+    enum Output { LIVE, TRANSITIONS, ONLINE, NUM_OUTPUTS };
+
+    struct Config
+    {
+        int servers;
+        double threshold;
+        double kappa;
+        int tau;
+        double capacity;        // requests per second at a load of 1
+    };
+
+    struct State
+    {
+        Config config;              // what the state was made with
+        uint64_t offset;            // bytes of the trace consumed
+        uint64_t samples;
+        int last_m;                 // offline m_t of the last sample, -1 before the first
+        uint64_t lengths[NUM_OUTPUTS];
+        online::Snapshot online;
+    };
+
+    struct Pass
+    {
+        uint64_t samples;           // new this pass
+        uint64_t bytes;             // of trace parsed
+        double seconds;
+        bool restarted;
+        bool skipped;               // no trace to read, nothing touched
+    };
+
+    inline bool same_config(const Config &a, const Config &b)
+    {
+        return a.servers == b.servers && a.threshold == b.threshold && a.kappa == b.kappa && a.tau == b.tau &&
+               a.capacity == b.capacity;
+    }
+
+    // text, one field per line, %a for doubles so they read back exactly
+    inline bool save_state(const string &filename, const State &s)
+    {
+        string tmp = filename + ".tmp";
+        FILE *out = fopen(tmp.c_str(), "w");
+        if(!out) { return false; }
+
+        const online::Snapshot &o = s.online;
+        fprintf(out, "follow 1\n");
+        fprintf(out, "config %d %a %a %d %a\n", s.config.servers, s.config.threshold, s.config.kappa, s.config.tau,
+                s.config.capacity);
+        fprintf(out, "trace %llu %llu %d\n", (unsigned long long)s.offset, (unsigned long long)s.samples, s.last_m);
+        fprintf(out, "outputs %llu %llu %llu\n", (unsigned long long)s.lengths[LIVE],
+                (unsigned long long)s.lengths[TRANSITIONS], (unsigned long long)s.lengths[ONLINE]);
+        fprintf(out, "online %lld %d %d %d\n", (long long)o.now, o.busy, o.spare, o.waking);
+        fprintf(out, "totals %llu %llu %llu %a\n", (unsigned long long)o.totals.samples,
+                (unsigned long long)o.totals.server_seconds, (unsigned long long)o.totals.transitions, o.totals.dropped);
+        fprintf(out, "spares %zu", o.spares.size());
+        for(const online::SpareRun &r: o.spares) { fprintf(out, " %lld %d", (long long)r.since, r.count); }
+        fprintf(out, "\n");
+
+        bool ok = fflush(out) == 0 && fsync(fileno(out)) == 0;
+        ok = fclose(out) == 0 && ok;
+        return ok && rename(tmp.c_str(), filename.c_str()) == 0;
+    }
+
+    // false if there is no state or it cannot be read
+    inline bool load_state(const string &filename, State &s)
+    {
+        FILE *in = fopen(filename.c_str(), "r");
+        if(!in) { return false; }
+
+        online::Snapshot &o = s.online;
+        unsigned long long offset, samples, live, transitions, online, t_samples, t_seconds, t_transitions;
+        long long now;
+        size_t runs = 0;
+        int version = 0;
+        bool ok =
+            fscanf(in, "follow %d\n", &version) == 1 && version == 1 &&
+            fscanf(in, "config %d %la %la %d %la\n", &s.config.servers, &s.config.threshold, &s.config.kappa,
+                   &s.config.tau, &s.config.capacity) == 5 &&
+            fscanf(in, "trace %llu %llu %d\n", &offset, &samples, &s.last_m) == 3 &&
+            fscanf(in, "outputs %llu %llu %llu\n", &live, &transitions, &online) == 3 &&
+            fscanf(in, "online %lld %d %d %d\n", &now, &o.busy, &o.spare, &o.waking) == 4 &&
+            fscanf(in, "totals %llu %llu %llu %la\n", &t_samples, &t_seconds, &t_transitions, &o.totals.dropped) == 4 &&
+            fscanf(in, "spares %zu", &runs) == 1;
+
+        o.spares.clear();
+        for(size_t i=0; ok && i<runs; i++)
+        {
+            long long since;
+            int count;
+            ok = fscanf(in, " %lld %d", &since, &count) == 2;
+            o.spares.push_back(online::SpareRun{since, count});
+        }
+        fclose(in);
+        if(!ok) { return false; }
+
+        s.offset  = offset;
+        s.samples = samples;
+        s.lengths[LIVE]        = live;
+        s.lengths[TRANSITIONS] = transitions;
+        s.lengths[ONLINE]      = online;
+        o.now = now;
+        o.totals.samples        = t_samples;
+        o.totals.server_seconds = t_seconds;
+        o.totals.transitions    = t_transitions;
+        return true;
+    }
+
+    class Follower
+    {
+        private:
+            string trace_file, state_file;
+            string outputs[NUM_OUTPUTS];
+            Config config;
+            State state;
+            online::OnlineBalancer engine;
+
+            // nothing consumed, empty outputs
+            void reset(void)
+            {
+                this->engine = online::OnlineBalancer(this->config.servers, this->config.threshold, this->config.kappa,
+                                                      this->config.tau);
+                this->state.config  = this->config;
+                this->state.offset  = 0;
+                this->state.samples = 0;
+                this->state.last_m  = -1;
+                for(int i=0; i<NUM_OUTPUTS; i++) { this->state.lengths[i] = 0; }
+                this->state.online = this->engine.snapshot();
+            }
+
+        public:
+            /*
+             * outputs are offline m_t, the transitions between them and the
+             * online controller's m_t, one value per line as export_data()
+             * writes them
+             */
+            Follower(string trace_file, string state_file, string live, string transitions, string online,
+                     const Config &config) :
+                trace_file(trace_file), state_file(state_file), config(config),
+                engine(config.servers, config.threshold, config.kappa, config.tau)
+            {
+                this->outputs[LIVE]        = live;
+                this->outputs[TRANSITIONS] = transitions;
+                this->outputs[ONLINE]      = online;
+                this->reset();
+            }
+
+            const State &get_state(void) const { return this->state; }
+
+            // take in whatever was appended to the trace since the last pass
+            Pass step(void)
+            {
+                auto start = chrono::steady_clock::now();
+                Pass p = {0, 0, 0, false, false};
+
+                trace::MappedFile file(this->trace_file);
+                if(!file.valid())
+                {
+                    p.skipped = true;
+                    p.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                    return p;
+                }
+
+                if(!load_state(this->state_file, this->state) || !same_config(this->state.config, this->config))
+                {
+                    this->reset();
+                    p.restarted = true;
+                }
+
+                if(file.size() < this->state.offset)
+                {
+                    this->reset();
+                    p.restarted = true;
+                }
+                this->engine.restore(this->state.online);
+
+                // only up to the last separator, a value still being written waits for the next pass
+                const char *from = file.data() + this->state.offset;
+                const char *to   = file.end();
+                while(to > from && !trace::is_separator(to[-1])) { to--; }
+
+                vector<double> load;
+                if(to > from) { trace::parse_range(from, to, this->config.capacity, load); }
+
+                // cut off anything a pass wrote without saving the state
+                FILE *out[NUM_OUTPUTS];
+                for(int i=0; i<NUM_OUTPUTS; i++)
+                {
+                    int fd = open(this->outputs[i].c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+                    if(fd >= 0 && ftruncate(fd, off_t(this->state.lengths[i])) != 0) { close(fd); fd = -1; }
+                    out[i] = fd >= 0 ? fdopen(fd, "a") : NULL;
+                    if(out[i]) { setvbuf(out[i], NULL, _IOFBF, 1 << 20); }
+                }
+
+                int block[kernels::BLOCK];
+                for(size_t first=0; first<load.size(); first+=kernels::BLOCK)
+                {
+                    size_t n = min(size_t(kernels::BLOCK), load.size() - first);
+                    kernels::provision(load.data() + first, n, this->config.threshold, this->config.servers, 1, block);
+                    for(size_t i=0; i<n; i++)
+                    {
+                        int m = block[i];
+                        if(out[LIVE]) { fprintf(out[LIVE], "%d\n", m); }
+                        if(this->state.last_m >= 0 && out[TRANSITIONS])
+                        {
+                            fprintf(out[TRANSITIONS], "%d\n", abs(m - this->state.last_m));
+                        }
+                        this->state.last_m = m;
+
+                        int live = this->engine.push(load[first + i]).live;
+                        if(out[ONLINE]) { fprintf(out[ONLINE], "%d\n", live); }
+                    }
+                }
+
+                bool ok = true;
+                for(int i=0; i<NUM_OUTPUTS; i++)
+                {
+                    if(!out[i]) { ok = false; continue; }
+                    struct stat st;
+                    ok = fflush(out[i]) == 0 && fstat(fileno(out[i]), &st) == 0 && ok;
+                    ok = fclose(out[i]) == 0 && ok;
+                    this->state.lengths[i] = ok ? uint64_t(st.st_size) : 0;
+                }
+
+                if(to > from) { this->state.offset = uint64_t(to - file.data()); }
+                this->state.samples += load.size();
+                this->state.online   = this->engine.snapshot();
+                if(!ok || !save_state(this->state_file, this->state)) { cerr << "follow: could not save state" << endl; }
+
+                p.samples = load.size();
+                p.bytes   = to > from ? uint64_t(to - from) : 0;
+                p.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                return p;
+            }
+    };
+};
+#endif
@@ -0,0 +1,224 @@
+/*
+ * Load forecasting header file
+ *
+ * O(1) per sample predictors of the load h samples ahead, and a
+ * provisioning run that uses them to wake servers before the load
+ * arrives. waking takes the horizon: servers asked for at t are live at
+ * t+h, servers can be put to sleep at once. a purely reactive policy
+ * (offline_lb's rule on the current sample) is the same run with
+ * Method NONE, so the two are compared under the same wake delay
+ *
+ *   EWMA          exponentially weighted mean of the load
+ *   HOLT_WINTERS  additive level, trend and a seasonal profile of period
+ *                 samples (a day of seconds by default)
+ *   WINDOW_MAX    largest load of the last window samples
+ *
+ * the prediction never goes below the current sample
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef FORECAST_H
+#define FORECAST_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+namespace forecast
+{
+    enum Method { NONE, EWMA, HOLT_WINTERS, WINDOW_MAX };
+
+    inline const char *method_name(Method m)
+    {
+        switch(m)
+        {
+            case EWMA:         return "ewma";
+            case HOLT_WINTERS: return "holt-winters";
+            case WINDOW_MAX:   return "window-max";
+            default:           return "none";
+        }
+    }
+
+    // NONE for anything it does not know
+    inline Method parse_method(const string &s)
+    {
+        if(s == "ewma") { return EWMA; }
+        if(s == "hw" || s == "holt-winters") { return HOLT_WINTERS; }
+        if(s == "max" || s == "window-max") { return WINDOW_MAX; }
+        return NONE;
+    }
+
+    class Ewma
+    {
+        private:
+            double alpha, level;
+            bool started;
+
+        public:
+            Ewma(double alpha) : alpha(alpha), level(0), started(false) {}
+
+            void update(double x)
+            {
+                this->level = this->started ? this->alpha*x + (1 - this->alpha)*this->level : x;
+                this->started = true;
+            }
+
+            double predict(int) const { return this->level; }
+    };
+
+    class HoltWinters
+    {
+        private:
+            double alpha, beta, gamma;
+            double level, trend;
+            vector<double> season;
+            size_t t;               // samples seen
+
+        public:
+            HoltWinters(double alpha, double beta, double gamma, size_t period) :
+                alpha(alpha), beta(beta), gamma(gamma), level(0), trend(0), season(max<size_t>(1, period), 0.0), t(0) {}
+
+            void update(double x)
+            {
+                size_t p = this->season.size();
+                double &s = this->season[this->t % p];
+
+                if(this->t == 0) { this->level = x; }
+                else
+                {
+                    double prev = this->level;
+                    this->level = this->alpha*(x - s) + (1 - this->alpha)*(this->level + this->trend);
+                    this->trend = this->beta*(this->level - prev) + (1 - this->beta)*this->trend;
+                }
+                // the first period only learns the profile
+                s = this->t < p ? x - this->level : this->gamma*(x - this->level) + (1 - this->gamma)*s;
+                this->t++;
+            }
+
+            // load h samples after the last one seen
+            double predict(int h) const
+            {
+                size_t p = this->season.size();
+                return this->level + h*this->trend + this->season[(this->t - 1 + h) % p];
+            }
+    };
+
+    // sliding window maximum over a ring buffer, amortised O(1)
+    class WindowMax
+    {
+        private:
+            vector<int64_t> index;
+            vector<double> value;
+            size_t head, count;
+            int64_t t;
+            int64_t window;
+
+        public:
+            WindowMax(size_t window) : index(window + 1), value(window + 1), head(0), count(0), t(0),
+                                       window(max<int64_t>(1, window)) {}
+
+            void update(double x)
+            {
+                size_t cap = this->value.size();
+                while(this->count > 0)
+                {
+                    size_t back = this->head + this->count - 1;
+                    if(this->value[back < cap ? back : back - cap] > x) { break; }
+                    this->count--;
+                }
+                size_t slot = this->head + this->count;
+                if(slot >= cap) { slot -= cap; }
+                this->index[slot] = this->t;
+                this->value[slot] = x;
+                this->count++;
+
+                while(this->index[this->head] <= this->t - this->window)
+                {
+                    if(++this->head == cap) { this->head = 0; }
+                    this->count--;
+                }
+                this->t++;
+            }
+
+            double predict(int) const { return this->count ? this->value[this->head] : 0; }
+    };
+
+    struct Config
+    {
+        Method method;
+        int horizon;            // samples ahead, also the wake delay
+        double alpha, beta, gamma;
+        size_t period;
+        size_t window;
+
+        Config() : method(NONE), horizon(60), alpha(0.05), beta(0.001), gamma(0.1), period(86400), window(600) {}
+    };
+
+    struct Outcome
+    {
+        uint64_t samples;
+        double server_seconds;
+        uint64_t transitions;
+        double dropped;         // load above what the live servers carry
+    };
+
+    /*
+     * provision a trace with the wake delay of the horizon, servers asked
+     * for from the forecast (or, with NONE, the current sample) by the
+     * offline_lb rule. m_t is written to out if it is not null
+     */
+    inline Outcome provision(const double *load, size_t n, double threshold, int servers, const Config &config,
+                             int *out = NULL)
+    {
+        Ewma ewma(config.alpha);
+        HoltWinters hw(config.method == HOLT_WINTERS ? config.alpha : 0, config.beta, config.gamma,
+                       config.method == HOLT_WINTERS ? config.period : 1);
+        WindowMax wmax(config.method == WINDOW_MAX ? config.window : 1);
+
+        const int d = max(0, config.horizon);
+        const double unit = threshold/servers;
+
+        // servers asked for over the last d samples, to see what is ready
+        vector<int> asked(d + 1, servers);
+        int live = servers;
+
+        Outcome o = {0, 0, 0, 0};
+        for(size_t t=0; t<n; t++)
+        {
+            double x = load[t];
+            double want = x;
+            switch(config.method)
+            {
+                case EWMA:         ewma.update(x); want = max(x, ewma.predict(d)); break;
+                case HOLT_WINTERS: hw.update(x);   want = max(x, hw.predict(d)); break;
+                case WINDOW_MAX:   wmax.update(x); want = wmax.predict(d); break;
+                default: break;
+            }
+
+            int m = (int)((want/threshold)*servers);
+            if(m < 1) { m = 1; }
+            else if(m > servers) { m = servers; }
+            asked[t % (d + 1)] = m;
+
+            // what was asked for d samples ago is up now, what is on can stay
+            int ready = max(live, asked[(t + 1) % (d + 1)]);
+            int next = min(m, ready);
+
+            if(t > 0) { o.transitions += abs(next - live); }
+            live = next;
+
+            o.server_seconds += live;
+            o.dropped += max(0.0, x - live*unit);
+            if(out) { out[t] = live; }
+        }
+        o.samples = n;
+        return o;
+    }
+};
+#endif
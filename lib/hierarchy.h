@@ -0,0 +1,215 @@
+/*
+ * Hierarchical balancing header file
+ *
+ * per-cluster provisioning with a global coordinator. every cluster
+ * decides m_t for its own demand series (the offline_lb rule against its
+ * own servers and threshold), the clusters in parallel. then for every
+ * sample the coordinator takes the demand a cluster cannot serve with
+ * the servers it has live and moves it: first into the headroom of
+ * servers that are already live, and only then by turning on more
+ * servers in clusters that have them. what no cluster can take is
+ * dropped. samples are independent at that stage, so the coordinator
+ * runs in parallel over ranges of time
+ *
+ * m live servers serve m*threshold/servers, in both steps. the local rule
+ * rounds m down, so the part of a cluster's own demand above that is
+ * excess too, and needs a live server somewhere like any other
+ *
+ * demand is in units of a cluster's capacity, 1.0 being all of its
+ * servers fully loaded, the same units as the global trace
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef HIERARCHY_H
+#define HIERARCHY_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "kernels.h"
+#include "parallel.h"
+
+using namespace std;
+
+namespace hierarchy
+{
+    // demand of every cluster, cluster c's series contiguous
+    struct Demand
+    {
+        int clusters;
+        size_t samples;
+        vector<double> load;
+
+        const double *cluster(int c) const { return this->load.data() + size_t(c)*this->samples; }
+        double *cluster(int c) { return this->load.data() + size_t(c)*this->samples; }
+    };
+
+    /*
+     * spread one global trace over clusters. cluster c gets a share
+     * proportional to 1/(c+1)^skew of the total and sees the trace shift*c
+     * samples later (time zones), wrapping around. with skew 0 and shift 0
+     * every cluster carries the global load
+     */
+    inline Demand split(const vector<double> &global, int clusters, double skew = 0, int64_t shift = 0)
+    {
+        Demand d;
+        d.clusters = max(0, clusters);
+        d.samples  = global.size();
+        d.load.resize(size_t(d.clusters)*d.samples);
+        if(d.samples == 0) { return d; }
+
+        vector<double> share(d.clusters);
+        double sum = 0;
+        for(int c=0; c<d.clusters; c++) { share[c] = pow(c + 1.0, -skew); sum += share[c]; }
+
+        int64_t T = d.samples;
+        for(int c=0; c<d.clusters; c++)
+        {
+            double scale = share[c]/sum*d.clusters;
+            size_t offset = size_t(((shift*c) % T + T) % T);
+            double *out = d.cluster(c);
+            for(size_t t=0; t<d.samples; t++)
+            {
+                size_t src = t + offset;
+                out[t] = global[src < d.samples ? src : src - d.samples]*scale;
+            }
+        }
+        return d;
+    }
+
+    struct Totals
+    {
+        double server_seconds;
+        uint64_t transitions;
+        double excess;          // demand clusters could not serve with their own live servers
+        double shifted_live;    // moved into already live servers
+        double shifted_woken;   // moved into servers turned on for it
+        uint64_t woken;         // server-seconds turned on for shifted load
+        double dropped;         // demand no cluster could take
+    };
+
+    struct Result
+    {
+        int clusters;
+        size_t samples;
+        vector<int> servers;    // m of cluster c at sample t is servers[c*samples + t]
+        vector<int> total;      // live servers over all clusters per sample
+        Totals totals;
+
+        int live(int c, size_t t) const { return this->servers[size_t(c)*this->samples + t]; }
+    };
+
+    /*
+     * balance every cluster, each with servers servers and the given
+     * threshold. coordinate = false leaves the clusters on their own, to
+     * compare against
+     */
+    inline Result balance(const Demand &demand, int servers, double threshold, unsigned threads = 0,
+                          bool coordinate = true)
+    {
+        Result r;
+        r.clusters = demand.clusters;
+        r.samples  = demand.samples;
+        r.servers.resize(size_t(r.clusters)*r.samples);
+        r.total.assign(r.samples, 0);
+        r.totals = Totals{0, 0, 0, 0, 0, 0, 0};
+
+        const size_t T = r.samples;
+        const int C = r.clusters;
+
+        // local decisions, one cluster per task
+        parallel::parallel_for(C, threads, [&](size_t c)
+        {
+            kernels::provision(demand.cluster(c), T, threshold, servers, 1, r.servers.data() + c*T);
+        });
+
+        // the coordinator, one range of samples per task
+        const size_t chunk = 4096;
+        size_t chunks = (T + chunk - 1)/chunk;
+        vector<Totals> partial(chunks, Totals{0, 0, 0, 0, 0, 0, 0});
+        double unit = threshold/servers;    // what one server serves
+
+        // servers needed for an amount, the tolerance keeps m*unit at m
+        auto needed = [&](double amount) { return int(ceil(amount/unit - 1e-9)); };
+
+        parallel::parallel_for(chunks, threads, [&](size_t k)
+        {
+            Totals &p = partial[k];
+            vector<double> served(C);
+
+            for(size_t t=k*chunk; t<min(T, (k+1)*chunk); t++)
+            {
+                double excess = 0;
+                for(int c=0; c<C; c++)
+                {
+                    double d = max(0.0, demand.cluster(c)[t]);
+                    served[c] = min(d, r.servers[c*T + t]*unit);
+                    excess += d - served[c];
+                }
+                p.excess += excess;
+
+                if(coordinate && excess > 0)
+                {
+                    // into the headroom of servers already live
+                    for(int c=0; c<C && excess > 0; c++)
+                    {
+                        double room = r.servers[c*T + t]*unit - served[c];
+                        if(room <= 0) { continue; }
+                        double moved = min(room, excess);
+                        served[c] += moved;
+                        excess    -= moved;
+                        p.shifted_live += moved;
+                    }
+
+                    // then into servers turned on for it
+                    for(int c=0; c<C && excess > 0; c++)
+                    {
+                        double room = threshold - served[c];
+                        if(room <= 0) { continue; }
+                        double moved = min(room, excess);
+                        served[c] += moved;
+                        excess    -= moved;
+                        p.shifted_woken += moved;
+
+                        int &m = r.servers[c*T + t];
+                        int need = min(servers, needed(served[c]));
+                        if(need > m) { p.woken += need - m; m = need; }
+                    }
+                }
+                p.dropped += excess;
+
+                int live = 0;
+                for(int c=0; c<C; c++) { live += r.servers[c*T + t]; }
+                r.total[t] = live;
+                p.server_seconds += live;
+            }
+        });
+
+        // transitions per cluster, again one cluster per task
+        vector<uint64_t> transitions(C, 0);
+        parallel::parallel_for(C, threads, [&](size_t c)
+        {
+            const int *m = r.servers.data() + c*T;
+            uint64_t sum = 0;
+            for(size_t t=1; t<T; t++) { sum += abs(m[t] - m[t-1]); }
+            transitions[c] = sum;
+        });
+
+        for(const Totals &p: partial)
+        {
+            r.totals.server_seconds += p.server_seconds;
+            r.totals.excess         += p.excess;
+            r.totals.shifted_live   += p.shifted_live;
+            r.totals.shifted_woken  += p.shifted_woken;
+            r.totals.woken          += p.woken;
+            r.totals.dropped        += p.dropped;
+        }
+        for(uint64_t n: transitions) { r.totals.transitions += n; }
+        return r;
+    }
+};
+#endif
@@ -0,0 +1,232 @@
+/*
+ * Instrumentation header file
+ *
+ * nanosecond latency histograms per named phase (trace loading, topology
+ * build, each balancing algorithm, export). build with -DLB_INSTRUMENT to
+ * turn the timers on, without it INSTRUMENT() expands to nothing and the
+ * hot paths carry no clock reads at all
+ *
+ *   void run() { INSTRUMENT("offline_lb"); ... }
+ *
+ * histograms are log-linear, 32 buckets per power of two, so percentiles
+ * are within 3% of the real value and recording is a few adds. counters
+ * are atomic, phases may be timed from worker threads
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <iostream>
+
+using namespace std;
+
+namespace instrument
+{
+    // monotonic clock in nanoseconds
+    inline uint64_t now_ns(void)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec)*1000000000ull + uint64_t(ts.tv_nsec);
+    }
+
+    static const int SUB_BITS = 5;
+    static const int SUB      = 1 << SUB_BITS;
+    static const int BUCKETS  = SUB + (64 - SUB_BITS)*SUB;
+    static const int MAX_PHASES = 64;
+
+    /*
+     * values below 32 get a bucket each, above that every power of two is
+     * split into 32 equal buckets
+     */
+    inline int bucket_of(uint64_t v)
+    {
+        if(v < uint64_t(SUB)) { return int(v); }
+        int e = 63 - __builtin_clzll(v);
+        return SUB + (e - SUB_BITS)*SUB + int((v >> (e - SUB_BITS)) & (SUB - 1));
+    }
+
+    // largest value that lands in bucket b
+    inline uint64_t bucket_top(int b)
+    {
+        if(b < SUB) { return uint64_t(b); }
+        int e   = (b - SUB)/SUB + SUB_BITS;
+        int sub = (b - SUB) % SUB;
+        return ((uint64_t(SUB + sub + 1) << (e - SUB_BITS)) - 1);
+    }
+
+    class Histogram
+    {
+        private:
+            atomic<uint64_t> counts[BUCKETS];
+            atomic<uint64_t> calls, total, longest;
+
+        public:
+            Histogram() : calls(0), total(0), longest(0)
+            {
+                for(int b=0; b<BUCKETS; b++) { this->counts[b].store(0, memory_order_relaxed); }
+            }
+
+            void record(uint64_t ns)
+            {
+                this->counts[bucket_of(ns)].fetch_add(1, memory_order_relaxed);
+                this->calls.fetch_add(1, memory_order_relaxed);
+                this->total.fetch_add(ns, memory_order_relaxed);
+
+                uint64_t seen = this->longest.load(memory_order_relaxed);
+                while(ns > seen && !this->longest.compare_exchange_weak(seen, ns, memory_order_relaxed)) {}
+            }
+
+            uint64_t get_calls(void) const { return this->calls.load(memory_order_relaxed); }
+            uint64_t get_total(void) const { return this->total.load(memory_order_relaxed); }
+            uint64_t get_max(void) const { return this->longest.load(memory_order_relaxed); }
+
+            // value at quantile q in [0, 1], the top of its bucket
+            uint64_t quantile(double q) const
+            {
+                uint64_t n = this->get_calls();
+                if(n == 0) { return 0; }
+
+                uint64_t rank = uint64_t(q*(n - 1)) + 1, seen = 0;
+                for(int b=0; b<BUCKETS; b++)
+                {
+                    seen += this->counts[b].load(memory_order_relaxed);
+                    if(seen >= rank) { return min(bucket_top(b), this->get_max()); }
+                }
+                return this->get_max();
+            }
+    };
+
+    struct Phase
+    {
+        const char *name;
+        Histogram hist;
+    };
+
+    /*
+     * fixed table of phases, looked up by name once per call site and
+     * never freed, so call sites can hold on to the pointer
+     */
+    class Registry
+    {
+        private:
+            Phase phases[MAX_PHASES];
+            atomic<int> used;
+            mutex lock;
+
+        public:
+            Registry() : used(0) {}
+
+            Phase *get(const char *name)
+            {
+                lock_guard<mutex> guard(this->lock);
+                int n = this->used.load();
+                for(int i=0; i<n; i++)
+                {
+                    if(strcmp(this->phases[i].name, name) == 0) { return &this->phases[i]; }
+                }
+                if(n == MAX_PHASES) { return NULL; }
+
+                this->phases[n].name = name;
+                this->used.store(n + 1);
+                return &this->phases[n];
+            }
+
+            int size(void) const { return this->used.load(); }
+            const Phase &at(int i) const { return this->phases[i]; }
+    };
+
+    inline Registry &registry(void)
+    {
+        static Registry r;
+        return r;
+    }
+
+    // times its enclosing scope into a phase
+    class Scope
+    {
+        private:
+            Phase *phase;
+            uint64_t start;
+
+        public:
+            Scope(Phase *phase) : phase(phase), start(now_ns()) {}
+            ~Scope() { if(this->phase) { this->phase->hist.record(now_ns() - this->start); } }
+    };
+
+    inline bool enabled(void)
+    {
+#ifdef LB_INSTRUMENT
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // summary table, one row per phase, times in microseconds
+    inline void report(ostream &out)
+    {
+        if(!enabled()) { return; }
+
+        Registry &r = registry();
+        char line[256];
+        snprintf(line, sizeof(line), "%-24s %10s %14s %12s %12s %12s %12s", "phase", "calls", "total ms", "mean us",
+                 "p50 us", "p99 us", "max us");
+        out << line << endl;
+        for(int i=0; i<r.size(); i++)
+        {
+            const Histogram &h = r.at(i).hist;
+            uint64_t calls = h.get_calls();
+            snprintf(line, sizeof(line), "%-24s %10llu %14.3f %12.3f %12.3f %12.3f %12.3f", r.at(i).name,
+                     (unsigned long long)calls, h.get_total()/1e6, calls ? h.get_total()/1e3/calls : 0.0,
+                     h.quantile(0.5)/1e3, h.quantile(0.99)/1e3, h.get_max()/1e3);
+            out << line << endl;
+        }
+    }
+
+    /*
+     * machine readable dump for comparing runs, CSV with times in
+     * nanoseconds. false if the file cannot be written
+     */
+    inline bool dump(string filename)
+    {
+        if(!enabled()) { return false; }
+
+        FILE *f = fopen(filename.c_str(), "w");
+        if(f == NULL) { return false; }
+
+        Registry &r = registry();
+        fprintf(f, "phase,calls,total_ns,p50_ns,p99_ns,max_ns\n");
+        for(int i=0; i<r.size(); i++)
+        {
+            const Histogram &h = r.at(i).hist;
+            fprintf(f, "%s,%llu,%llu,%llu,%llu,%llu\n", r.at(i).name, (unsigned long long)h.get_calls(),
+                    (unsigned long long)h.get_total(), (unsigned long long)h.quantile(0.5),
+                    (unsigned long long)h.quantile(0.99), (unsigned long long)h.get_max());
+        }
+        return fclose(f) == 0;
+    }
+};
+
+#define INSTRUMENT_CAT2(a, b) a##b
+#define INSTRUMENT_CAT(a, b) INSTRUMENT_CAT2(a, b)
+
+#ifdef LB_INSTRUMENT
+// time the rest of the enclosing scope as phase name (a string literal)
+#define INSTRUMENT(name) \
+    static instrument::Phase *INSTRUMENT_CAT(instrument_phase_, __LINE__) = instrument::registry().get(name); \
+    instrument::Scope INSTRUMENT_CAT(instrument_scope_, __LINE__)(INSTRUMENT_CAT(instrument_phase_, __LINE__))
+#else
+#define INSTRUMENT(name) do {} while(0)
+#endif
+#endif
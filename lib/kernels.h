@@ -0,0 +1,116 @@
+/*
+ * Batch kernels header file
+ *
+ * branch-free versions of the per-sample loops in LoadBalancer and
+ * Network::opt_loadbalancer. they write into caller owned buffers and give
+ * the same m_t, bit for bit, as the scalar loops: m_t is
+ * (int)((load/threshold)*servers) clamped to [floor, servers]
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace kernels
+{
+    // samples handled per block by the fused kernel, small enough to stay in L1
+    static const size_t BLOCK = 2048;
+
+    /*
+     * m_t for n samples. the clamp is ordered so a NaN load ends up on the
+     * floor, which is what the scalar int conversion gives on x86
+     */
+    inline void provision(const double *load, size_t n, double threshold, int servers, int floor, int *out)
+    {
+        const double lo = floor;
+        const double hi = servers;
+        size_t i = 0;
+
+#if defined(__AVX2__)
+        const __m256d thr_v = _mm256_set1_pd(threshold);
+        const __m256d lo_v  = _mm256_set1_pd(lo);
+        const __m256d hi_v  = _mm256_set1_pd(hi);
+
+        for(; i + 4 <= n; i += 4)
+        {
+            __m256d x = _mm256_mul_pd(_mm256_div_pd(_mm256_loadu_pd(load + i), thr_v), hi_v);
+            x = _mm256_blendv_pd(lo_v, x, _mm256_cmp_pd(x, lo_v, _CMP_GT_OQ));
+            x = _mm256_blendv_pd(hi_v, x, _mm256_cmp_pd(x, hi_v, _CMP_LT_OQ));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm256_cvttpd_epi32(x));
+        }
+#elif defined(__SSE2__)
+        const __m128d thr_v = _mm_set1_pd(threshold);
+        const __m128d lo_v  = _mm_set1_pd(lo);
+        const __m128d hi_v  = _mm_set1_pd(hi);
+
+        for(; i + 2 <= n; i += 2)
+        {
+            __m128d x = _mm_mul_pd(_mm_div_pd(_mm_loadu_pd(load + i), thr_v), hi_v);
+            __m128d m = _mm_cmpgt_pd(x, lo_v);
+            x = _mm_or_pd(_mm_and_pd(m, x), _mm_andnot_pd(m, lo_v));
+            m = _mm_cmplt_pd(x, hi_v);
+            x = _mm_or_pd(_mm_and_pd(m, x), _mm_andnot_pd(m, hi_v));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i), _mm_cvttpd_epi32(x));
+        }
+#endif
+        for(; i < n; i++)
+        {
+            double x = (load[i]/threshold)*hi;
+            x = x > lo ? x : lo;
+            x = x < hi ? x : hi;
+            out[i] = (int)x;
+        }
+    }
+
+    // |m_t - m_(t-1)| for t = 1..n-1, out holds n-1 values
+    inline void transitions(const int *m, size_t n, int *out)
+    {
+        size_t i = 1;
+
+#if defined(__AVX2__)
+        for(; i + 8 <= n; i += 8)
+        {
+            __m256i cur  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(m + i));
+            __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(m + i - 1));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i - 1), _mm256_abs_epi32(_mm256_sub_epi32(cur, prev)));
+        }
+#endif
+        for(; i < n; i++)
+        {
+            int d = m[i] - m[i-1];
+            out[i-1] = d < 0 ? -d : d;
+        }
+    }
+
+    /*
+     * m_t and the transitions between consecutive m_t in one pass, block by
+     * block so the transitions read m_t while it is still in cache
+     */
+    inline void provision_transitions(const double *load, size_t n, double threshold, int servers, int floor,
+                                      int *m_out, int *t_out)
+    {
+        for(size_t first=0; first<n; first+=BLOCK)
+        {
+            size_t len = min(BLOCK, n - first);
+            provision(load + first, len, threshold, servers, floor, m_out + first);
+
+            // the first transition of a block straddles the previous one
+            size_t from = first == 0 ? 0 : first - 1;
+            transitions(m_out + from, first + len - from, t_out + from);
+        }
+    }
+};
+#endif
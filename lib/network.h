@@ -17,6 +17,17 @@
 #include <iostream>
 
 #include "traffic.h"
+#include "fleet.h"
+#include "registry.h"
+#include "topology.h"
+#include "online.h"
+#include "kernels.h"
+#include "optimal.h"
+#include "instrument.h"
+#include "energy.h"
+#include "hierarchy.h"
+#include "forecast.h"
+#include "timeline.h"
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
 #include "ns3/csma-module.h"
@@ -38,20 +49,23 @@ class Server
         NetDeviceContainer net_nodes;
         Ipv4InterfaceContainer ip_interface;
 
+        // a rack of hosts behind one TOR, its load and on/spare state live
+        // in the registry row uuid, one row per rack
+        ServerTable *table;
         int uuid, cluster_id, size;
-        double load_amt;
         const double capacity = 0.7;
-        bool on, spare;
 
     public:
         // default constructor
         Server();
-        Server(NodeContainer *tor, int port, int uuid, int cluster_id, int size) : uuid(uuid), cluster_id(cluster_id), size(size), on(false), spare(false)
+        Server(NodeContainer *tor, int port, ServerTable *table, int cluster_id, int size, uint32_t system_id = 0) : table(table), uuid(table->add(cluster_id)), cluster_id(cluster_id), size(size)
         {
             // add the TOR switch to the rack
             this->nodes.Add(tor->Get(port));
             // create servers in the rack
-            this->nodes.Create(size);
+            NodeContainer hosts;
+            hosts.Create(size, system_id);
+            this->nodes.Add(hosts);
 
             // setup access connection
             CsmaHelper csma;
@@ -61,35 +75,36 @@ class Server
             // install the csma on the nodes
             this->net_nodes = csma.Install(this->nodes);
 
-            // install the IP stack
+            // install the IP stack on the whole rack at once
             InternetStackHelper ip_stack;
-
-            for(int i=1; i<=this->size; i++)
-            {
-                ip_stack.Install(this->nodes.Get(i));
-            }
+            ip_stack.Install(hosts);
 
         }
         ~Server() {}
 
-        NetDeviceContainer getNetDev() { return this->net_nodes; }
-        NodeContainer getNodes() { return this->nodes; }
+        const NetDeviceContainer &getNetDev() const { return this->net_nodes; }
+        const NodeContainer &getNodes() const { return this->nodes; }
+
+        int getID() const { return this->uuid; }
+        double getLoad() const { return this->table->get_load(this->uuid); }
+        void setLoad(double l) { this->table->set_load(this->uuid, l); }
 
-        int getID();
-        double getLoad() { return this->load_amt; }
+        bool isOn() const { return this->table->get_state(this->uuid) != SERVER_OFF; }
+        bool isSpare() const { return this->table->get_state(this->uuid) == SERVER_SPARE; }
+        void setState(ServerState s) { this->table->set_state(this->uuid, s); }
 
-        double getCapacity(void) { return this->capacity; }
+        double getCapacity(void) const { return this->capacity; }
 
-        int getClusterID();
+        int getClusterID() const { return this->cluster_id; }
 
-        Ipv4InterfaceContainer getIPContainer(void) { return this->ip_interface; }
+        const Ipv4InterfaceContainer &getIPContainer(void) const { return this->ip_interface; }
 
-        void setIP(string base, string mask)
+        void setIP(Ipv4Address base, Ipv4Mask mask)
         {
             Ipv4AddressHelper address;
 
             // address the rack
-            address.SetBase(base.c_str(), mask.c_str());
+            address.SetBase(base, mask);
             this->ip_interface = address.Assign(this->net_nodes);
             //cout << "Server range in a switch IP: "<< base << endl;
         }
@@ -99,25 +114,29 @@ class Cluster
 {
     private:
         int uuid, num_servers, num_sws;
+        uint32_t system_id;         // MPI rank simulating this cluster
         double load, load_threshold;
+        ServerTable *table;
+        topology::Addresses *addresses;
         vector<Server> servers;
         NodeContainer aggr_tor;
         NetDeviceContainer aggr_tor_net;
         Ipv4InterfaceContainer ip_interface;
-        string rack_ip, rack_mask;
 
     public:
         // default constructor
         Cluster();
 
-        Cluster(NodeContainer *origin, vector<string> ips, int s, int cluster_id, double load_thresh) : uuid(cluster_id), num_servers(s), load_threshold(load_thresh)
+        /*
+         * node 0 of aggr_tor is the cluster's aggregation switch, the only
+         * node with a link (p2p) out of the cluster, the TORs follow it
+         */
+        Cluster(uint32_t system_id, topology::Addresses *addresses, int s, int cluster_id, double load_thresh, ServerTable *table, int tors) : uuid(cluster_id), num_servers(s), system_id(system_id), load_threshold(load_thresh), table(table), addresses(addresses)
         {
-            this->aggr_tor.Add(origin->Get(0)); 
-
-            // how many TOR switches do we need
-            this->num_sws = int(sqrt(this->num_servers));
+            // how many TOR switches do we need, one per rack
+            this->num_sws = tors;
 
-            this->aggr_tor.Create(this->num_sws);
+            this->aggr_tor.Create(this->num_sws + 1, system_id);
 
             // access connections on the switches
             CsmaHelper csma;
@@ -126,64 +145,60 @@ class Cluster
 
             this-> aggr_tor_net = csma.Install(this->aggr_tor);
 
-            for(signed int i=1; i<=this->num_sws; i++)
-            {
-                // install an IP stack on the switches
-                InternetStackHelper ip_stack;
-                Ipv4AddressHelper address;
-
-                ip_stack.Install(this->aggr_tor.Get(i));
-                // IP address assign
-                address.SetBase(ips.at(i-1).c_str(), "255.255.255.0");
-                this->ip_interface = address.Assign(this->aggr_tor_net.Get(i));
-            }
+            // install an IP stack on the switches
+            InternetStackHelper ip_stack;
+            ip_stack.Install(this->aggr_tor);
 
-        }
+            // the switches share one subnet on the aggregation segment
+            uint32_t network;
+            int prefix;
+            this->addresses->tors.allocate(this->num_sws + 1, network, prefix);
 
-        void createServers(int port)
-        {
-            // install the IP stack
-            InternetStackHelper ip_stack;
             Ipv4AddressHelper address;
+            address.SetBase(Ipv4Address(network), Ipv4Mask(topology::AddressPool::mask(prefix)));
+            this->ip_interface = address.Assign(this->aggr_tor_net);
 
+        }
 
-            // address the tor switches
+        // a rack of size hosts behind TOR number port
+        void createServers(int port, int size)
+        {
             // create servers for this rack
-            Server rack(&this->aggr_tor,port,0,this->uuid, this->num_servers);
-            rack.setIP(this->rack_ip, this->rack_mask);
+            Server rack(&this->aggr_tor,port,this->table,this->uuid, size, this->system_id);
+
+            // the rack subnet holds its hosts and the TOR
+            uint32_t network;
+            int prefix;
+            this->addresses->racks.allocate(size + 1, network, prefix);
+            rack.setIP(Ipv4Address(network), Ipv4Mask(topology::AddressPool::mask(prefix)));
 
 
-            servers.push_back(rack);
+            servers.push_back(move(rack));
 
         }
 
         ~Cluster() {}
 
 
-        int getID();
+        int getID() const { return this->uuid; }
 
-        double getLoad(void)
-        {
-            double total_load = 0;
-
-            for(Server s: servers) 
-            {
-                total_load += s.getLoad();
-            }
+        // kept up to date by the registry as server loads change
+        double getLoad(void) const { return this->table->get_cluster_load(this->uuid); }
 
-            return total_load;
-        }
-        vector<Server> getServers() { return this->servers; }
-        NodeContainer getTOR(void) { return this->aggr_tor;  }
+        ClusterView view(void) const { return this->table->cluster(this->uuid); }
 
-        void setRackIP(string b, string mask) { this->rack_ip = b; this->rack_mask = mask; }
+        vector<Server> &getServers() { return this->servers; }
+        const NodeContainer &getTOR(void) const { return this->aggr_tor;  }
 };
 
-class Network
+class Network : public Fleet
 {
     private:
-        int num_servers, num_clusters;
-        double load, load_threshold;
+        double load;
+        bool built;
+        uint32_t rank, ranks;       // this process and how many simulate the network
+        ServerTable registry;
+        topology::Addresses addresses;
         vector<Cluster> clusters;
         NodeContainer origin;
         vector<NetDeviceContainer> origin_nets;
@@ -191,11 +206,49 @@ class Network
 
     public:
         // default constructor
-        Network() {}
+        Network() : built(false), rank(0), ranks(1) {}
+
+        // the topology is only built by build(), analytic runs never need it
+        Network(int s, int c, double t) : Fleet(s, c, t), built(false), rank(0), ranks(1) {}
+
+        /*
+         * distributed simulation: clusters are spread over ranks in blocks,
+         * the origin stays on rank 0. every rank builds the whole topology
+         * and only runs the nodes it owns. call before build()
+         */
+        void set_partition(uint32_t rank, uint32_t ranks)
+        {
+            this->rank  = rank;
+            this->ranks = ranks < 1 ? 1 : ranks;
+        }
+
+        uint32_t get_rank() { return this->rank; }
+
+        // true if this process simulates the node
+        bool is_local(Ptr<Node> node) { return node->GetSystemId() == this->rank; }
 
-        Network(int s, int c, double t) : num_servers(s), num_clusters(c), load_threshold(t)
+        bool is_built() { return this->built; }
+
+        // what build() will create, without creating it
+        topology::Plan plan() const { return topology::plan(this->num_servers, this->num_clusters); }
+
+        void build()
         {
-            this->origin.Create(this->num_clusters+1);
+            INSTRUMENT("topology.build");
+            if(this->built) { return; }
+
+            topology::Plan plan = this->plan();
+            if(!plan.fits)
+            {
+                cerr << "Topology does not fit the address plan!" << endl;
+                return;
+            }
+            this->built = true;
+
+            this->registry.reserve(uint64_t(plan.clusters)*plan.racks);
+            this->clusters.reserve(plan.clusters);
+
+            this->origin.Create(this->num_clusters+1, 0);
 
 
             this->p2p.SetDeviceAttribute("DataRate", StringValue("40Gbps"));
@@ -204,36 +257,19 @@ class Network
             ip_stack.Install(this->origin);
 
 
-            int sw_id = 1;
-            int rack_id = 1;
             // address the clusters (aggregate layer)
             for(int i=0; i< this->num_clusters; i++)
             {
-                vector<string> ips_bases;
-
-                for(int j=1; j<= pow(this->num_servers, 0.5); j++)
-                {
-                    string b = "10.";
-                    string id = to_string(sw_id++)+".1.0";
-                    string ip   = b+id;
-                    ips_bases.push_back(ip);
-                }
+                uint32_t owner = topology::owner(i, this->num_clusters, this->ranks);
+                Cluster cluster(owner, &this->addresses, this->num_servers, i, this->load_threshold, &this->registry, plan.tors);
 
-                Cluster cluster(&this->origin, ips_bases, this->num_servers,i, 0.75);
-
-
-                for(int j=1; j<= pow(this->num_servers, 0.5); j++)
+                // num_servers hosts per cluster, spread over the racks
+                for(int j=1; j<= plan.racks; j++)
                 {
-                    string b = "172.16.1";
-                    string id = to_string(rack_id++);
-                    string ip   = b+id+".0";
-                    
-                    // set rack IP for this cluster
-                    cluster.setRackIP(ip, "255.255.255.0");
-                    cluster.createServers(j);
+                    cluster.createServers(j, plan.rack_size(j-1));
                 }
 
-                this->clusters.push_back(cluster);
+                this->clusters.push_back(move(cluster));
             }
 
             // connect the aggregation to the core
@@ -243,15 +279,11 @@ class Network
 
         ~Network() {}
 
-        // custom copy contructor
-        /*
-        Network(const Network &other) : num_servers(other.num_servers), num_clusters(other.num_clusters)
-        {
-            // init the data block	
-            this->data = unique_ptr<unsigned char[]>(new unsigned char[other.height*other.width]);
-
-        }
-        */
+        // racks and clusters point into the registry, a copy or move would leave them dangling
+        Network(const Network &) = delete;
+        Network &operator=(const Network &) = delete;
+        Network(Network &&) = delete;
+        Network &operator=(Network &&) = delete;
         void connect_aggrs()
         {
         
@@ -269,7 +301,8 @@ class Network
             for(unsigned int i=0; i<this->clusters.size(); i++)
             {
                 NetDeviceContainer aggr_dev;
-                aggr_dev = this->p2p.Install(this->origin.Get(0), this->clusters.at(i).getTOR().Get(1));
+                // the only link into a cluster, so the only one that may cross ranks
+                aggr_dev = this->p2p.Install(this->origin.Get(0), this->clusters.at(i).getTOR().Get(0));
                 this->origin_nets.push_back(aggr_dev);
 
             }
@@ -279,28 +312,29 @@ class Network
 
             for(unsigned int i=0; i<this->origin_nets.size(); i++)
             {
-                Ipv4AddressHelper address;
-                string b = "192.168.";
-                string network = to_string(i+1);
-                string o = ".0";
-                string base   = b+network+o;
+                // a /30 per link
+                uint32_t network;
+                int prefix;
+                this->addresses.links.allocate(2, network, prefix);
 
-                address.SetBase(base.c_str(),"255.255.255.0");
+                Ipv4AddressHelper address;
+                address.SetBase(Ipv4Address(network), Ipv4Mask(topology::AddressPool::mask(prefix)));
                 Ipv4InterfaceContainer interface_p2p1 = address.Assign(this->origin_nets.at(i));
             }
 
 
         }
 
-        vector<Server> get_server_nodes() 
+        // non-owning, valid while the network lives
+        vector<Server *> get_server_nodes() 
         {
-            vector<Server> servers;
+            vector<Server *> servers;
 
-            for(int i=0; i<this->num_clusters; i++) 
+            for(unsigned int i=0; i<this->clusters.size(); i++) 
             {
-                for(Server server: clusters.at(i).getServers())
+                for(Server &server: clusters.at(i).getServers())
                 {
-                    servers.push_back(server); 
+                    servers.push_back(&server); 
                 }
             }
 
@@ -308,8 +342,9 @@ class Network
         }
         
 
-        vector<int> opt_loadbalancer(vector<double> load_sequence)
+        vector<int> opt_loadbalancer(const vector<double> &load_sequence)
         {
+            INSTRUMENT("opt_loadbalancer");
             // initialise m_t servers that need to be live to
             // serve the load
             vector<int> servers;
@@ -319,21 +354,33 @@ class Network
             {
                 int m_t = (int)((load/this->load_threshold)*this->num_servers);
 
-                if (m_t < this->num_servers) { servers.push_back(m_t); }
+                if (m_t < 0) { servers.push_back(0); }
+                else if (m_t < this->num_servers) { servers.push_back(m_t); }
                 else { servers.push_back(this->num_servers); }
             }
 
             return servers;
         }
 
+        // batch version of opt_loadbalancer into a caller owned buffer
+        void opt_loadbalancer(const vector<double> &load_sequence, vector<int> &servers)
+        {
+            INSTRUMENT("opt_loadbalancer");
+            servers.resize(load_sequence.size());
+            kernels::provision(load_sequence.data(), load_sequence.size(), this->load_threshold, this->num_servers, 0,
+                               servers.data());
+        }
+
         
         PointToPointHelper getP2P() { return this->p2p; }
 
-        double get_threshold() { return this->load_threshold; }
-        int get_servers() { return this->num_servers; }
-        int get_clusters(){ return this->num_clusters; }
-        vector<Cluster> getClusters() { return this->clusters; }
-        vector<NetDeviceContainer> getNetDevs() { return this->origin_nets; }
+        // the node clients reach the CDN through
+        Ptr<Node> get_origin() { return this->origin.Get(0); }
+
+        vector<Cluster> &getClusters() { return this->clusters; }
+        const vector<NetDeviceContainer> &getNetDevs() const { return this->origin_nets; }
+
+        ServerTable &get_registry() { return this->registry; }
 
 };
 
@@ -342,14 +389,14 @@ class LoadBalancer  : public Application
     private:
         uint32_t total_packets;
         vector<uint32_t> load_per_time;
-        clock_t start_time;
-        clock_t stop_time;
+        uint64_t start_time;    // monotonic, nanoseconds
+        online::Totals online_totals;
 
 
     public:
-        LoadBalancer() : total_packets(0), load_per_time(), stop_time()
+        LoadBalancer() : total_packets(0), load_per_time(), online_totals()
         {
-            start_time = clock();
+            start_time = instrument::now_ns();
             cout << "Installed Load Balancer" << endl;
         }
 
@@ -357,71 +404,163 @@ class LoadBalancer  : public Application
 
         uint32_t get_total_packets() { return this->total_packets;}
 
-        uint32_t timestamp(void)
+        // nanoseconds since the balancer was created
+        uint64_t timestamp(void)
+        {
+            return instrument::now_ns() - this->start_time;
+        }
+
+        /*
+         * online algorithm: one decision per load sample with kappa*servers
+         * spares kept live and idle spares hibernating after tau seconds.
+         * returns m_t per sample, totals are kept in get_online_totals()
+         */
+        vector<int> online_lb(const Fleet &cdn, const vector<double> &traffic, double kappa, int tau)
         {
-            return (clock() - this->start_time)*1.0/CLOCKS_PER_SEC; 
+            INSTRUMENT("online_lb");
+            online::OnlineBalancer engine(cdn.get_servers(), cdn.get_threshold(), kappa, tau);
+            vector<int> servers = engine.replay(traffic);
+
+            this->online_totals = engine.get_totals();
+            return servers;
         }
 
-        void online_lb(Network &cdn, vector<double> traffic, int kappa, int tau)
+        // online_lb with every decision metered as it is made
+        vector<int> online_lb(const Fleet &cdn, const vector<double> &traffic, double kappa, int tau, energy::Meter &meter)
         {
-            /* some servers need to be turned off */
-            
-            /* check if current live servers can manage current load */
-            int lambda_t = (int)((load/cdn.get_threshold())*cdn.get_servers());
-            int m_t = cdn.get_servers();
-            
-            if(lambda_t > m_t )
+            INSTRUMENT("online_lb");
+            online::OnlineBalancer engine(cdn.get_servers(), cdn.get_threshold(), kappa, tau);
+            vector<int> servers = engine.replay(traffic, [&](double load, const online::Decision &d)
             {
-                /* insufficient live servers for current load */ 
-                // drop lambda_t - m_t load
-                // server the rest of the load, 
-                // turn on (lambda_t - m_t)/threshold servers and assign as spare in t+1 
-                cout << "insufficient live servers for load" << endl;
-            }
-            else
+                meter.push(load, d.live);
+            });
+
+            this->online_totals = engine.get_totals();
+            return servers;
+        }
+
+        const online::Totals &get_online_totals(void) { return this->online_totals; }
+
+        /*
+         * energy of the offline_lb schedule without keeping it, m_t is
+         * worked out a block at a time and fed straight to the meter
+         */
+        energy::Tally offline_energy(const Fleet &cdn, const vector<double> &traffic, energy::Meter &meter)
+        {
+            INSTRUMENT("offline_energy");
+            int block[kernels::BLOCK];
+            for(size_t i=0; i<traffic.size(); i+=kernels::BLOCK)
             {
-                /* live servers numbered (lambda_t/threshold) +1 ... m_t are spare */ 
-                // -------- spare capacity rule
-                int spare = int(kappa*cdn.get_servers());
-                int c_spares = m_t - lambda_t; // current spares
+                size_t n = min(size_t(kernels::BLOCK), traffic.size() - i);
+                kernels::provision(traffic.data() + i, n, cdn.get_threshold(), cdn.get_servers(), 1, block);
+                meter.push(traffic.data() + i, block, n);
+            }
+            return meter.get_totals();
+        }
 
-                if (c_spares < spare) { cout << "spare rule ends" << endl; }
-                // -------- hibernate rule
+        /*
+         * the offline_lb schedule as a run-length timeline, m_t worked out a
+         * block at a time so the per-second series never exists
+         */
+        timeline::Timeline offline_timeline(const Fleet &cdn, const vector<double> &traffic)
+        {
+            INSTRUMENT("offline_timeline");
+            timeline::Timeline t(cdn.get_servers());
+            int block[kernels::BLOCK];
+            for(size_t i=0; i<traffic.size(); i+=kernels::BLOCK)
+            {
+                size_t n = min(size_t(kernels::BLOCK), traffic.size() - i);
+                kernels::provision(traffic.data() + i, n, cdn.get_threshold(), cdn.get_servers(), 1, block);
+                t.push(block, n);
             }
+            t.shrink();
+            return t;
         }
 
-        vector<int> offline_lb2(Network &cdn, vector<double> traffic, int k) 
+        vector<int> offline_lb2(const Fleet &cdn, const vector<double> &traffic, int k) 
         {
-            vector<int> servers;
+            INSTRUMENT("offline_lb2");
             vector<int> transitions;
-            int i = 0; 
+            int prev = 0;
+            bool first = true;
+
             // find out how many servers, m_t, can serve load_t
             for(double load: traffic)
             {
                 int m_t = (int)((load/cdn.get_threshold())*cdn.get_servers());
                 
-                if (m_t < 1) { servers.push_back(1);}   // minimum set of servers
+                if (m_t < 1) { m_t = 1; }   // minimum set of servers
+                else if (m_t >= cdn.get_servers()) { m_t = cdn.get_servers(); } // all servers be firing
 
-                else if (m_t < cdn.get_servers()) 
-                { 
-                    // check server transitions that need to take place
-                    // by checking m_(t-1)
-                    if(i>0)
-                    {
-                        int transition = abs(m_t - servers[i]);
-                        transitions.push_back(transition);
-                        cout << "Transitions: "<< transition << endl;
-                    }
-                    servers.push_back(m_t); 
-                    i+=1;
-                }
-                else { servers.push_back(cdn.get_servers()); } // all servers be firing
+                // check server transitions that need to take place
+                // by checking m_(t-1)
+                if(!first) { transitions.push_back(abs(m_t - prev)); }
+
+                prev = m_t;
+                first = false;
             }
 
             return transitions;
         }
-        vector<int> offline_lb(Network &cdn, vector<double> traffic) 
+
+        /*
+         * batch versions of offline_lb and offline_lb2, same results written
+         * into caller owned buffers (resized, so they can be reused)
+         */
+        void offline_lb(const Fleet &cdn, const vector<double> &traffic, vector<int> &servers)
+        {
+            INSTRUMENT("offline_lb");
+            servers.resize(traffic.size());
+            kernels::provision(traffic.data(), traffic.size(), cdn.get_threshold(), cdn.get_servers(), 1, servers.data());
+        }
+
+        void offline_lb2(const Fleet &cdn, const vector<double> &traffic, vector<int> &servers, vector<int> &transitions)
+        {
+            INSTRUMENT("offline_lb2");
+            servers.resize(traffic.size());
+            transitions.resize(traffic.empty() ? 0 : traffic.size() - 1);
+            kernels::provision_transitions(traffic.data(), traffic.size(), cdn.get_threshold(), cdn.get_servers(), 1,
+                                           servers.data(), transitions.data());
+        }
+
+        /*
+         * optimal offline schedule, energy per live server-second e against
+         * k per server transition. see optimal.h
+         */
+        optimal::Schedule offline_opt(const Fleet &cdn, const vector<double> &traffic, double k, double e = 1.0)
+        {
+            INSTRUMENT("offline_opt");
+            return optimal::solve(traffic, cdn.get_threshold(), cdn.get_servers(), k, e);
+        }
+
+        /*
+         * every cluster provisioned for its own demand, in parallel, and
+         * demand a cluster cannot serve moved to others before more
+         * servers are turned on. see hierarchy.h
+         */
+        hierarchy::Result hierarchical_lb(const Fleet &cdn, const hierarchy::Demand &demand, unsigned threads = 0)
+        {
+            INSTRUMENT("hierarchical_lb");
+            return hierarchy::balance(demand, cdn.get_servers(), cdn.get_threshold(), threads);
+        }
+
+        /*
+         * servers woken config.horizon samples ahead from a forecast of the
+         * load, m_t per sample into servers. config.method NONE is the
+         * offline_lb rule under the same wake delay. see forecast.h
+         */
+        forecast::Outcome predictive_lb(const Fleet &cdn, const vector<double> &traffic, const forecast::Config &config,
+                                        vector<int> &servers)
+        {
+            INSTRUMENT("predictive_lb");
+            servers.resize(traffic.size());
+            return forecast::provision(traffic.data(), traffic.size(), cdn.get_threshold(), cdn.get_servers(), config,
+                                       servers.data());
+        }
+
+        vector<int> offline_lb(const Fleet &cdn, const vector<double> &traffic) 
         {
+            INSTRUMENT("offline_lb");
             vector<int> servers;
 
             // find out how many servers, m_t, can serve load_t
@@ -0,0 +1,252 @@
+/*
+ * Online load balancer header file
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef ONLINE_H
+#define ONLINE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <cmath>
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+#include "instrument.h"
+
+using namespace std;
+
+namespace online
+{
+    // what the controller did for one load sample
+    struct Decision
+    {
+        int lambda;         // servers the sample needs
+        int live;           // m_t, servers serving or spare
+        int busy;           // live servers carrying load
+        int spare;          // live servers idling
+        int woken;          // hibernating servers turned on, live from t+1
+        int hibernated;     // spares that timed out this tick
+        double dropped;     // load that could not be served
+    };
+
+    struct Totals
+    {
+        uint64_t samples;
+        uint64_t server_seconds;
+        uint64_t transitions;
+        double dropped;
+    };
+
+    // count spares idle since the same second
+    struct SpareRun
+    {
+        int64_t since;
+        int count;
+    };
+
+    // everything push() depends on, to carry a controller over to a later run
+    struct Snapshot
+    {
+        int64_t now;
+        int busy, spare, waking;
+        vector<SpareRun> spares;    // oldest first
+        Totals totals;
+    };
+
+    /*
+     * streaming controller: one push() per second of load. live servers are
+     * either busy or spare; the kappa rule keeps int(kappa*servers) spares
+     * live, spares above that hibernate after idling for tau seconds, and
+     * demand above m_t is dropped while woken servers come up for t+1.
+     *
+     * a sample needs lambda = ceil(load*servers/threshold) servers (within
+     * a small tolerance), the fewest that carry it, so load is dropped
+     * exactly when lambda > m_t or the load is above the whole fleet.
+     * offline_lb rounds down instead and leaves the remainder unserved
+     *
+     * spares are kept as runs of (idle since, count) so that every push is
+     * amortised O(1): the newest spares are used first, the oldest time out
+     */
+    class OnlineBalancer
+    {
+        private:
+            int num_servers;
+            double load_threshold;
+            int spare_target;
+            int tau;
+
+            int64_t now;
+            int busy, spare, waking;
+            deque<SpareRun> spares;
+            Totals totals;
+
+            void add_spares(int n)
+            {
+                if(n <= 0) { return; }
+                if(!this->spares.empty() && this->spares.back().since == this->now) { this->spares.back().count += n; }
+                else { this->spares.push_back({this->now, n}); }
+                this->spare += n;
+            }
+
+            // newest spares pick up load first
+            void take_spares(int n)
+            {
+                this->spare -= n;
+                while(n > 0)
+                {
+                    SpareRun &run = this->spares.back();
+                    int used = min(n, run.count);
+                    run.count -= used;
+                    n -= used;
+                    if(run.count == 0) { this->spares.pop_back(); }
+                }
+            }
+
+            // oldest spares idle for tau seconds go to sleep
+            int hibernate(int n)
+            {
+                int slept = 0;
+                while(slept < n && !this->spares.empty() && this->now - this->spares.front().since >= this->tau)
+                {
+                    SpareRun &run = this->spares.front();
+                    int off = min(n - slept, run.count);
+                    run.count -= off;
+                    slept += off;
+                    if(run.count == 0) { this->spares.pop_front(); }
+                }
+                this->spare -= slept;
+                return slept;
+            }
+
+        public:
+            OnlineBalancer(int servers, double threshold, double kappa, int tau) :
+                num_servers(servers), load_threshold(threshold), tau(tau), now(0), busy(0), spare(0), waking(0)
+            {
+                this->spare_target = min(servers, max(0, int(kappa*servers)));
+                this->totals = Totals{0, 0, 0, 0.0};
+
+                // the fleet starts fully live and idle
+                this->add_spares(servers);
+            }
+
+            Decision push(double load)
+            {
+                Decision d;
+
+                // servers woken last tick are up now
+                this->add_spares(this->waking);
+                this->waking = 0;
+
+                int live = this->busy + this->spare;
+                double unit = this->load_threshold/this->num_servers;     // what one server carries
+                int lambda = (int)min(double(this->num_servers), ceil(load/unit - 1e-9));
+                if(lambda < 0) { lambda = 0; }
+                if(lambda > this->num_servers) { lambda = this->num_servers; }
+
+                d.lambda     = lambda;
+                d.woken      = 0;
+                d.hibernated = 0;
+                d.dropped    = 0.0;
+
+                int asleep = this->num_servers - live;
+
+                if(lambda > live)
+                {
+                    // insufficient live servers: everything live is busy, the
+                    // rest of the load is dropped and servers are woken for t+1
+                    this->take_spares(this->spare);
+                    this->busy = live;
+
+                    d.woken = min(asleep, lambda - live + this->spare_target);
+                }
+                else
+                {
+                    if(lambda > this->busy) { this->take_spares(lambda - this->busy); }
+                    else { this->add_spares(this->busy - lambda); }
+                    this->busy = lambda;
+
+                    // -------- spare capacity rule
+                    if(this->spare < this->spare_target) { d.woken = min(asleep, this->spare_target - this->spare); }
+                    // -------- hibernate rule, never below one live server
+                    else
+                    {
+                        int excess = min(this->spare - this->spare_target, live - 1);
+                        if(excess > 0) { d.hibernated = this->hibernate(excess); }
+                    }
+                }
+
+                // whatever the live servers cannot carry, also above the whole
+                // fleet's capacity where lambda is clamped
+                if(lambda > live || load > this->load_threshold) { d.dropped = max(0.0, load - live*unit); }
+
+                this->waking = d.woken;
+
+                d.busy  = this->busy;
+                d.spare = this->spare;
+                d.live  = this->busy + this->spare;
+
+                this->totals.samples++;
+                this->totals.server_seconds += d.live;
+                this->totals.transitions    += d.woken + d.hibernated;
+                this->totals.dropped        += d.dropped;
+
+                this->now++;
+                return d;
+            }
+
+            /*
+             * replay a whole trace, writing m_t per sample. each(load, d) is
+             * called with every decision as it is made, outside the timed
+             * part
+             */
+            template <typename F>
+            vector<int> replay(const vector<double> &traffic, F each)
+            {
+                vector<int> live(traffic.size());
+                for(size_t i=0; i<traffic.size(); i++)
+                {
+                    Decision d;
+                    {
+                        // per decision latency, only with -DLB_INSTRUMENT
+                        INSTRUMENT("online.decision");
+                        d = this->push(traffic[i]);
+                    }
+                    live[i] = d.live;
+                    each(traffic[i], d);
+                }
+                return live;
+            }
+
+            vector<int> replay(const vector<double> &traffic)
+            {
+                return this->replay(traffic, [](double, const Decision &) {});
+            }
+
+            Snapshot snapshot(void) const
+            {
+                Snapshot s = {this->now, this->busy, this->spare, this->waking,
+                              vector<SpareRun>(this->spares.begin(), this->spares.end()), this->totals};
+                return s;
+            }
+
+            // continue from a snapshot of a controller with the same parameters
+            void restore(const Snapshot &s)
+            {
+                this->now    = s.now;
+                this->busy   = s.busy;
+                this->spare  = s.spare;
+                this->waking = s.waking;
+                this->spares.assign(s.spares.begin(), s.spares.end());
+                this->totals = s.totals;
+            }
+
+            const Totals &get_totals(void) const { return this->totals; }
+            int64_t get_time(void) const { return this->now; }
+            int get_live(void) const { return this->busy + this->spare; }
+            int get_waking(void) const { return this->waking; }
+    };
+};
+#endif
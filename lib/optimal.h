@@ -0,0 +1,168 @@
+/*
+ * Optimal offline provisioning header file
+ *
+ * minimises  e*sum(x_t) + k*sum_(t>0)|x_t - x_(t-1)|  subject to
+ * d_t <= x_t <= M, with d_t the offline_lb demand. like offline_lb and the
+ * online controller, only changes between samples are transitions, x_0
+ * comes for free
+ *
+ * both terms split into one on/off problem per server level l (x_t >= l),
+ * and a level is best kept on through an idle gap of g seconds iff
+ * e*g <= 2k (e*g <= k for the gaps at the start and the end of the trace,
+ * which are paid for on one side only). filling short gaps level by level
+ * is a grayscale closing of d with a flat window of W+1 seconds,
+ * W = floor(2k/e), which two monotone deques compute in O(T). deque values
+ * are distinct integers in [0, M], so working memory is O(M) whatever the
+ * window
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef OPTIMAL_H
+#define OPTIMAL_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "kernels.h"
+
+using namespace std;
+
+namespace optimal
+{
+    struct Schedule
+    {
+        vector<int> servers;        // x_t
+        uint64_t server_seconds;
+        uint64_t transitions;       // between samples, not powering up x_0
+        double energy;              // e*server_seconds
+        double switching;           // k*transitions
+        double total;
+    };
+
+    /*
+     * fixed capacity monotone queue of (index, value), at most M+1 entries
+     */
+    class MonotoneQueue
+    {
+        private:
+            vector<int64_t> index;
+            vector<int> value;
+            size_t head, count;
+            bool keep_max;
+
+        public:
+            MonotoneQueue(size_t capacity, bool keep_max) : index(capacity), value(capacity), head(0), count(0),
+                                                            keep_max(keep_max) {}
+
+            void push(int64_t i, int v)
+            {
+                while(this->count > 0)
+                {
+                    int back = this->value[(this->head + this->count - 1) % this->value.size()];
+                    if(this->keep_max ? back <= v : back >= v) { this->count--; }
+                    else { break; }
+                }
+                size_t slot = (this->head + this->count) % this->value.size();
+                this->index[slot] = i;
+                this->value[slot] = v;
+                this->count++;
+            }
+
+            // drop entries with index < first
+            void expire(int64_t first)
+            {
+                while(this->count > 0 && this->index[this->head] < first)
+                {
+                    this->head = (this->head + 1) % this->value.size();
+                    this->count--;
+                }
+            }
+
+            int front(void) const { return this->value[this->head]; }
+    };
+
+    /*
+     * demand in x (one entry per second, each in [0, servers]) is replaced by
+     * the optimal schedule in place
+     */
+    inline void close_gaps(vector<int> &x, int servers, double k, double e)
+    {
+        const int64_t T = x.size();
+        if(T == 0) { return; }
+
+        // longest interior and trailing gaps worth bridging, capped by the trace
+        int64_t W  = e > 0 ? int64_t(min(floor(2*k/e), double(T))) : T;
+        int64_t W2 = e > 0 ? int64_t(min(floor(k/e), double(T))) : T;
+        int64_t w  = W + 1;
+
+        // a virtual full fleet at either end lets the leading and trailing
+        // gaps close iff they are <= W2
+        int64_t full_from = T + W - W2;
+        int64_t full_until = -(W - W2);
+
+        auto demand = [&](int64_t j) -> int
+        {
+            if(j < 0) { return j < full_until ? servers : 0; }
+            if(j < T) { return x[j]; }
+            return j < full_from ? 0 : servers;
+        };
+
+        // a level above the peak is one gap touching both ends, it stays off
+        int peak = 0;
+        for(int v: x) { peak = max(peak, v); }
+
+        MonotoneQueue dilate(servers + 2, true);
+        MonotoneQueue erode(servers + 2, false);
+
+        // D_s = max d[s, s+w), x_t = min D(t-w, t]. d is read w-1 samples
+        // ahead of D and D 0 samples ahead of x, so x is written behind the reads
+        for(int64_t j = -2*(w-1); j < T + w - 1; j++)
+        {
+            dilate.expire(j - w + 1);
+            dilate.push(j, demand(j));
+
+            int64_t s = j - (w - 1);
+            erode.expire(s - w + 1);
+            erode.push(s, dilate.front());
+
+            if(s >= 0) { x[s] = min(peak, erode.front()); }
+        }
+    }
+
+    // objective breakdown of any schedule under the same cost model
+    inline void account(Schedule &sched, double k, double e)
+    {
+        sched.server_seconds = 0;
+        sched.transitions    = 0;
+
+        for(size_t t=0; t<sched.servers.size(); t++)
+        {
+            sched.server_seconds += sched.servers[t];
+            if(t > 0) { sched.transitions += abs(sched.servers[t] - sched.servers[t-1]); }
+        }
+
+        sched.energy    = e*sched.server_seconds;
+        sched.switching = k*sched.transitions;
+        sched.total     = sched.energy + sched.switching;
+    }
+
+    /*
+     * optimal schedule for a load trace: demand is the offline_lb m_t,
+     * e is the energy of one live server for one second
+     */
+    inline Schedule solve(const vector<double> &load, double threshold, int servers, double k, double e = 1.0)
+    {
+        Schedule sched;
+        sched.servers.resize(load.size());
+        kernels::provision(load.data(), load.size(), threshold, servers, 1, sched.servers.data());
+
+        close_gaps(sched.servers, servers, k, e);
+        account(sched, k, e);
+        return sched;
+    }
+};
+#endif
@@ -0,0 +1,108 @@
+/*
+ * Parallel loop header file
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdlib.h>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <algorithm>
+
+using namespace std;
+
+namespace parallel
+{
+    // threads to use when the caller asks for 0
+    inline unsigned default_threads(void)
+    {
+        unsigned n = thread::hardware_concurrency();
+        return n == 0 ? 1 : n;
+    }
+
+    /*
+     * run fn(i) for i in [0, n) on a set of worker threads. every worker
+     * starts with a contiguous slice of the indices and takes from its
+     * front; a worker that runs dry steals the back half of the fullest
+     * slice, so uneven tasks still keep every core busy
+     */
+    template <typename F>
+    void parallel_for(size_t n, unsigned threads, F fn)
+    {
+        if(threads == 0) { threads = default_threads(); }
+        if(threads > n) { threads = max<size_t>(1, n); }
+
+        if(threads <= 1)
+        {
+            for(size_t i=0; i<n; i++) { fn(i); }
+            return;
+        }
+
+        struct Slice
+        {
+            mutex lock;
+            size_t lo, hi;
+        };
+
+        vector<unique_ptr<Slice>> slices;
+        for(unsigned w=0; w<threads; w++)
+        {
+            slices.emplace_back(new Slice());
+            slices[w]->lo = n*w/threads;
+            slices[w]->hi = n*(w+1)/threads;
+        }
+
+        auto worker = [&](unsigned w)
+        {
+            Slice &own = *slices[w];
+            while(true)
+            {
+                size_t i;
+                {
+                    lock_guard<mutex> guard(own.lock);
+                    i = own.lo < own.hi ? own.lo++ : n;
+                }
+                if(i < n) { fn(i); continue; }
+
+                // steal half of the biggest remaining slice
+                unsigned victim = w;
+                size_t most = 0;
+                for(unsigned v=0; v<threads; v++)
+                {
+                    if(v == w) { continue; }
+                    lock_guard<mutex> guard(slices[v]->lock);
+                    size_t left = slices[v]->hi - slices[v]->lo;
+                    if(left > most) { most = left; victim = v; }
+                }
+                if(most == 0) { return; }
+
+                Slice &other = *slices[victim];
+                size_t lo, hi;
+                {
+                    lock_guard<mutex> guard(other.lock);
+                    size_t left = other.hi - other.lo;
+                    if(left == 0) { continue; }
+                    hi = other.hi;
+                    lo = other.hi - (left + 1)/2;
+                    other.hi = lo;
+                }
+                {
+                    lock_guard<mutex> guard(own.lock);
+                    own.lo = lo;
+                    own.hi = hi;
+                }
+            }
+        };
+
+        vector<thread> workers;
+        for(unsigned w=1; w<threads; w++) { workers.emplace_back(worker, w); }
+        worker(0);
+        for(thread &t: workers) { t.join(); }
+    }
+};
+#endif
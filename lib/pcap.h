@@ -0,0 +1,152 @@
+/*
+ * Pcap header file
+ *
+ * counts packets and bytes per time bucket straight out of memory mapped
+ * libpcap captures (what CsmaHelper::EnablePcap writes), reading only the
+ * record headers. microsecond and nanosecond captures of either byte
+ * order are read, pcapng is not
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef PCAP_H
+#define PCAP_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "trace.h"
+
+using namespace std;
+
+namespace pcap
+{
+    static const size_t FILE_HEADER   = 24;
+    static const size_t RECORD_HEADER = 16;
+    static const uint32_t MAX_SPAN    = 366*86400;    // seconds after t0 counted by default
+
+    struct Format
+    {
+        bool valid;
+        bool swapped;       // written on a machine of the other byte order
+        bool nanoseconds;
+    };
+
+    inline uint32_t swap32(uint32_t v) { return __builtin_bswap32(v); }
+
+    inline uint32_t read32(const char *p, bool swapped)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return swapped ? swap32(v) : v;
+    }
+
+    inline Format format(const trace::MappedFile &file)
+    {
+        Format f = {false, false, false};
+        if(!file.valid() || file.size() < FILE_HEADER) { return f; }
+
+        uint32_t magic = read32(file.data(), false);
+        switch(magic)
+        {
+            case 0xa1b2c3d4: f.valid = true; break;
+            case 0xa1b23c4d: f.valid = true; f.nanoseconds = true; break;
+            case 0xd4c3b2a1: f.valid = true; f.swapped = true; break;
+            case 0x4d3cb2a1: f.valid = true; f.swapped = true; f.nanoseconds = true; break;
+        }
+        return f;
+    }
+
+    // seconds of the first packet, -1 for an empty or unreadable capture
+    inline int64_t first_time(const trace::MappedFile &file)
+    {
+        Format f = format(file);
+        if(!f.valid || file.size() < FILE_HEADER + RECORD_HEADER) { return -1; }
+        return read32(file.data() + FILE_HEADER, f.swapped);
+    }
+
+    /*
+     * per bucket totals over [t0, t0 + span), bucket seconds wide. record
+     * times are not trusted, one bad one must not size the buckets, so a
+     * packet past the span is counted as late and nothing else
+     */
+    struct Counts
+    {
+        int64_t t0;
+        uint32_t bucket;
+        uint32_t span;
+        vector<uint64_t> packets;
+        vector<uint64_t> bytes;
+        uint64_t truncated;     // records cut off by the end of the file
+        uint64_t early;         // packets before t0, not counted
+        uint64_t late;          // packets span or more seconds after t0, not counted
+
+        Counts(int64_t t0 = 0, uint32_t bucket = 1, uint32_t span = MAX_SPAN) :
+            t0(t0), bucket(bucket < 1 ? 1 : bucket), span(span), truncated(0), early(0), late(0) {}
+
+        void add(const Counts &other)
+        {
+            if(other.packets.size() > this->packets.size())
+            {
+                this->packets.resize(other.packets.size(), 0);
+                this->bytes.resize(other.bytes.size(), 0);
+            }
+            for(size_t i=0; i<other.packets.size(); i++)
+            {
+                this->packets[i] += other.packets[i];
+                this->bytes[i]   += other.bytes[i];
+            }
+            this->truncated += other.truncated;
+            this->early     += other.early;
+            this->late      += other.late;
+        }
+    };
+
+    /*
+     * add every packet of a capture to counts, false if it is not a pcap.
+     * bytes are the original wire lengths, not what was captured
+     */
+    inline bool count(const trace::MappedFile &file, Counts &counts)
+    {
+        Format f = format(file);
+        if(!f.valid) { return false; }
+
+        const char *p   = file.data() + FILE_HEADER;
+        const char *end = file.end();
+        while(p + RECORD_HEADER <= end)
+        {
+            int64_t sec     = read32(p, f.swapped);
+            uint32_t incl   = read32(p + 8, f.swapped);
+            uint32_t orig   = read32(p + 12, f.swapped);
+            if(size_t(end - p) < RECORD_HEADER + incl) { counts.truncated++; break; }
+            p += RECORD_HEADER + incl;
+
+            if(sec < counts.t0) { counts.early++; continue; }
+            if(sec - counts.t0 >= counts.span) { counts.late++; continue; }
+            size_t b = size_t(sec - counts.t0)/counts.bucket;
+            if(b >= counts.packets.size())
+            {
+                // grow in steps so a long capture does not resize per bucket, never past the span
+                size_t n = min(max(b + 1, counts.packets.size()*2), size_t(counts.span - 1)/counts.bucket + 1);
+                counts.packets.resize(n, 0);
+                counts.bytes.resize(n, 0);
+            }
+            counts.packets[b]++;
+            counts.bytes[b] += orig;
+        }
+        return true;
+    }
+
+    // drop the empty buckets count() grew past the last packet
+    inline void trim(Counts &counts)
+    {
+        size_t n = counts.packets.size();
+        while(n > 0 && counts.packets[n-1] == 0) { n--; }
+        counts.packets.resize(n);
+        counts.bytes.resize(n);
+    }
+};
+#endif
@@ -0,0 +1,160 @@
+/*
+ * Server registry header file
+ *
+ * structure-of-arrays table of every server in the CDN. a row is a
+ * Server, which in the topology is a rack of hosts behind one TOR, not a
+ * single host; the analytic algorithms count hosts and do not use the
+ * table. rows of a cluster are contiguous, so a cluster is a non-owning
+ * view over a slice of the columns, and per-cluster and global totals are
+ * kept up to date on every change instead of being summed on each query.
+ * in a simulation TraceReplayer sets each rack's load as it changes the
+ * flow rates and BalancerApp sets the racks on and off
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+#include <cassert>
+
+using namespace std;
+
+enum ServerState : uint8_t
+{
+    SERVER_OFF   = 0,
+    SERVER_ON    = 1,   // live and carrying load
+    SERVER_SPARE = 2    // live and idling
+};
+
+// a cluster's slice of the table, valid until servers are added
+struct ClusterView
+{
+    const int *ids;
+    const double *load;
+    const uint8_t *state;
+    size_t size;
+    double total_load;
+    int live, spare;
+};
+
+class ServerTable
+{
+    private:
+        // columns, one entry per server
+        vector<int> ids;
+        vector<int> cluster_ids;
+        vector<double> load;
+        vector<uint8_t> state;
+
+        // cluster c owns rows [cluster_begin[c], cluster_begin[c+1])
+        vector<size_t> cluster_begin;
+        vector<double> cluster_load;
+        vector<int> cluster_live, cluster_spare;
+
+        double total_load;
+        int total_live, total_spare;
+
+        void count_state(int cluster, uint8_t s, int delta)
+        {
+            if(s != SERVER_OFF) { this->cluster_live[cluster] += delta; this->total_live += delta; }
+            if(s == SERVER_SPARE) { this->cluster_spare[cluster] += delta; this->total_spare += delta; }
+        }
+
+    public:
+        // default constructor
+        ServerTable() : cluster_begin(1, 0), total_load(0), total_live(0), total_spare(0) {}
+
+        ~ServerTable() {}
+
+        /*
+         * add a server to a cluster and return its row. clusters are
+         * filled in order, a cluster id may not be revisited
+         */
+        int add(int cluster_id)
+        {
+            assert(cluster_id + 1 >= int(this->cluster_begin.size()) - 1);
+
+            while(int(this->cluster_begin.size()) <= cluster_id + 1)
+            {
+                this->cluster_begin.push_back(this->ids.size());
+                this->cluster_load.push_back(0);
+                this->cluster_live.push_back(0);
+                this->cluster_spare.push_back(0);
+            }
+
+            int row = this->ids.size();
+            this->ids.push_back(row);
+            this->cluster_ids.push_back(cluster_id);
+            this->load.push_back(0);
+            this->state.push_back(SERVER_OFF);
+
+            this->cluster_begin[cluster_id + 1] = this->ids.size();
+            return row;
+        }
+
+        void reserve(size_t n)
+        {
+            this->ids.reserve(n);
+            this->cluster_ids.reserve(n);
+            this->load.reserve(n);
+            this->state.reserve(n);
+        }
+
+        // O(1): the cluster and global totals move by the difference
+        void set_load(int row, double l)
+        {
+            double delta = l - this->load[row];
+            this->load[row] = l;
+            this->cluster_load[this->cluster_ids[row]] += delta;
+            this->total_load += delta;
+        }
+
+        void set_state(int row, ServerState s)
+        {
+            int cluster = this->cluster_ids[row];
+            this->count_state(cluster, this->state[row], -1);
+            this->count_state(cluster, s, 1);
+            this->state[row] = s;
+        }
+
+        // recompute the running load totals, clears accumulated rounding
+        void resync(void)
+        {
+            this->total_load = 0;
+            for(size_t c=0; c<this->cluster_load.size(); c++)
+            {
+                double sum = 0;
+                for(size_t i=this->cluster_begin[c]; i<this->cluster_begin[c+1]; i++) { sum += this->load[i]; }
+                this->cluster_load[c] = sum;
+                this->total_load += sum;
+            }
+        }
+
+        size_t size(void) const { return this->ids.size(); }
+        int clusters(void) const { return this->cluster_load.size(); }
+
+        int get_cluster(int row) const { return this->cluster_ids[row]; }
+        double get_load(int row) const { return this->load[row]; }
+        ServerState get_state(int row) const { return ServerState(this->state[row]); }
+
+        double get_cluster_load(int c) const { return this->cluster_load[c]; }
+        int get_cluster_live(int c) const { return this->cluster_live[c]; }
+        int get_cluster_spare(int c) const { return this->cluster_spare[c]; }
+
+        double get_total_load(void) const { return this->total_load; }
+        int get_total_live(void) const { return this->total_live; }
+        int get_total_spare(void) const { return this->total_spare; }
+
+        ClusterView cluster(int c) const
+        {
+            size_t first = this->cluster_begin[c];
+            size_t n     = this->cluster_begin[c+1] - first;
+            return ClusterView{this->ids.data() + first, this->load.data() + first, this->state.data() + first, n,
+                               this->cluster_load[c], this->cluster_live[c], this->cluster_spare[c]};
+        }
+};
+#endif
@@ -0,0 +1,194 @@
+/*
+ * Trace replay header file
+ *
+ * drives the simulation from the same per-second load trace the balancing
+ * algorithms use. every rack host gets a sink and a Load flow from the
+ * origin; the demand of each time bucket is split over the flows by
+ * changing their rates from a single event per bucket, and each bucket's
+ * event schedules the next, so the event queue never holds more than one
+ * replay event however long the trace is
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+#include <iostream>
+
+#include "network.h"
+#include "traffic.h"
+
+using namespace ns3;
+using namespace std;
+
+struct ReplayStats
+{
+    uint64_t flows;
+    uint64_t buckets;           // replay events run
+    uint64_t rate_updates;      // flow rate changes applied
+    uint64_t send_events;       // Load events, read at the end
+    uint64_t packets;
+};
+
+class TraceReplayer
+{
+    private:
+        const vector<double> &load;
+        uint32_t bucket;            // seconds per rate update
+        double peak_bps;            // rate of the whole CDN at a load of 1
+        uint32_t burst;
+        bool poisson;               // exponential gaps between a flow's sends
+
+        vector<Ptr<Load>> flows;
+        vector<size_t> flow_rack_index; // rack of each flow's host, into racks
+        vector<Server *> racks;         // racks with a flow, sender only
+        vector<double> rack_load;       // scratch, per rack
+        vector<double> shares;      // fraction of the demand per flow
+        vector<uint64_t> rates;     // last rate set per flow, unchanged rates are skipped
+        size_t next;
+        double demand;              // bps of the current bucket
+        ReplayStats stats;
+
+        void apply(void)
+        {
+            for(size_t f=0; f<this->flows.size(); f++)
+            {
+                uint64_t bps = uint64_t(this->demand*this->shares[f]);
+                if(bps == this->rates[f]) { continue; }
+                this->rates[f] = bps;
+                this->flows[f]->set_rate(DataRate(bps));
+                this->stats.rate_updates++;
+            }
+
+            // rack loads in trace units into the registry, which keeps the
+            // cluster and global totals
+            fill(this->rack_load.begin(), this->rack_load.end(), 0.0);
+            for(size_t f=0; f<this->flows.size(); f++) { this->rack_load[this->flow_rack_index[f]] += this->shares[f]; }
+            double scale = this->peak_bps > 0 ? this->demand/this->peak_bps : 0;
+            for(size_t r=0; r<this->racks.size(); r++) { this->racks[r]->setLoad(this->rack_load[r]*scale); }
+        }
+
+        void update(void)
+        {
+            if(this->next >= this->load.size()) { return; }
+
+            // mean load over the bucket
+            size_t end = min(this->load.size(), this->next + this->bucket);
+            double sum = 0;
+            for(size_t i=this->next; i<end; i++) { sum += this->load[i]; }
+            this->demand = sum/(end - this->next)*this->peak_bps;
+            this->apply();
+
+            this->stats.buckets++;
+            this->next = end;
+            if(this->next < this->load.size()) { Simulator::Schedule(Seconds(this->bucket), &TraceReplayer::update, this); }
+        }
+
+    public:
+        TraceReplayer(const vector<double> &load, uint32_t bucket, DataRate peak, uint32_t burst = 1, bool poisson = false) :
+            load(load), bucket(bucket < 1 ? 1 : bucket), peak_bps(peak.GetBitRate()), burst(burst), poisson(poisson), next(0),
+            demand(0)
+        {
+            this->stats = ReplayStats{0, 0, 0, 0, 0};
+        }
+
+        ~TraceReplayer() {}
+
+        /*
+         * sinks on every rack host, flows from the origin, every host gets
+         * the same share of the demand. in a distributed run each rank only
+         * installs applications on the nodes it owns
+         */
+        void install(Network &cdn, uint32_t packet_size = 1000)
+        {
+            uint16_t port = 8080;
+            Ptr<Node> origin = cdn.get_origin();
+
+            PacketSinkHelper sink("ns3::UdpSocketFactory", InetSocketAddress(Ipv4Address::GetAny(), port));
+
+            vector<Server *> racks = cdn.get_server_nodes();
+            uint64_t hosts = 0;
+            for(Server *rack: racks) { hosts += rack->getNodes().GetN() - 1; }
+
+            bool sender = cdn.is_local(origin);
+            for(Server *rack: racks)
+            {
+                if(sender)
+                {
+                    this->racks.push_back(rack);
+                    this->rack_load.push_back(0);
+                }
+                // node 0 of a rack is its TOR
+                for(uint32_t i=1; i<rack->getNodes().GetN(); i++)
+                {
+                    if(cdn.is_local(rack->getNodes().Get(i)))
+                    {
+                        ApplicationContainer sink_app = sink.Install(rack->getNodes().Get(i));
+                        sink_app.Start(Seconds(0.));
+                    }
+                    if(!sender) { continue; }
+
+                    Ptr<Socket> socket = Socket::CreateSocket(origin, UdpSocketFactory::GetTypeId());
+                    Address dest(InetSocketAddress(rack->getIPContainer().GetAddress(i), port));
+
+                    Ptr<Load> app = CreateObject<Load>();
+                    app->setup(socket, dest, packet_size, UINT32_MAX, DataRate(0), this->burst);
+                    app->set_poisson(this->poisson);
+                    origin->AddApplication(app);
+                    app->SetStartTime(Seconds(0.));
+                    app->SetStopTime(Seconds(double(this->load.size())));
+
+                    this->flows.push_back(app);
+                    this->flow_rack_index.push_back(this->racks.size() - 1);
+                    this->shares.push_back(1.0/hosts);
+                    this->rates.push_back(0);
+                }
+            }
+
+            this->stats.flows = this->flows.size();
+            if(sender) { Simulator::Schedule(Seconds(0.), &TraceReplayer::update, this); }
+        }
+
+        /*
+         * spread the demand over the flows to live hosts only, one entry per
+         * flow in install() order. takes effect at once
+         */
+        void set_live(const vector<uint8_t> &live)
+        {
+            size_t n = 0;
+            for(size_t f=0; f<this->flows.size() && f<live.size(); f++) { n += live[f] ? 1 : 0; }
+            if(n == 0) { return; }
+
+            for(size_t f=0; f<this->flows.size(); f++) { this->shares[f] = f < live.size() && live[f] ? 1.0/n : 0.0; }
+            this->apply();
+        }
+
+        // seconds of trace being replayed
+        double duration(void) const { return double(this->load.size()); }
+
+        ReplayStats get_stats(void)
+        {
+            this->stats.send_events = 0;
+            this->stats.packets = 0;
+            for(Ptr<Load> app: this->flows)
+            {
+                this->stats.send_events += app->get_events();
+                this->stats.packets     += app->get_packets_sent();
+            }
+            return this->stats;
+        }
+
+        void report(ostream &out)
+        {
+            ReplayStats s = this->get_stats();
+            out << "replay: " << this->load.size() << "s of trace, " << s.flows << " flows, " << s.buckets
+                << " bucket events, " << s.rate_updates << " rate updates, " << s.send_events << " send events, "
+                << s.packets << " packets, ~" << (this->flows.size()*(sizeof(Load) + 3*sizeof(double)))/1024
+                << "KB of flow state" << endl;
+        }
+};
+#endif
@@ -0,0 +1,312 @@
+/*
+ * Simulation profiler header file
+ *
+ * where the time of a packet-level run goes. the event scheduler is
+ * wrapped by one that counts what goes through it: events scheduled per
+ * handler class (the class whose member function an event calls, e.g.
+ * Load, CsmaNetDevice, PacketSink), events run and the depth of the event
+ * queue. every interval of simulated time a sample of events per wall
+ * second and queue depth is taken, the samples go to a CSV
+ *
+ * ns-3's schedulers are named here by their short names: map (the
+ * default), heap, calendar and list. which is fastest depends on how
+ * many events are pending, so main can time each on the scenario itself
+ * (--scheduler=auto) and run with the fastest
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef SIMPROFILE_H
+#define SIMPROFILE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <typeinfo>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include <cxxabi.h>
+
+#include "instrument.h"
+#include "ns3/core-module.h"
+#include "ns3/scheduler.h"
+
+using namespace ns3;
+using namespace std;
+
+namespace simprofile
+{
+    static const char *SCHEDULERS[] = {"map", "heap", "calendar", "list"};
+    static const int NUM_SCHEDULERS = 4;
+
+    // ns-3 type of a scheduler's short name, empty if it is not one
+    inline string type_name(const string &name)
+    {
+        if(name == "map")      { return "ns3::MapScheduler"; }
+        if(name == "heap")     { return "ns3::HeapScheduler"; }
+        if(name == "calendar") { return "ns3::CalendarScheduler"; }
+        if(name == "list")     { return "ns3::ListScheduler"; }
+        return "";
+    }
+
+    /*
+     * the class an event calls into. events made from member functions
+     * carry the class in their type, MakeEvent<void (ns3::Load::*)(), ...>
+     */
+    inline string handler(const type_info &type)
+    {
+        int status = 0;
+        char *demangled = abi::__cxa_demangle(type.name(), NULL, NULL, &status);
+        string name = status == 0 && demangled ? demangled : type.name();
+        free(demangled);
+
+        size_t member = name.find("::*)");
+        if(member == string::npos) { return "function"; }
+        size_t open = name.rfind('(', member);
+        string cls = name.substr(open + 1, member - open - 1);
+        if(cls.compare(0, 5, "ns3::") == 0) { cls = cls.substr(5); }
+        return cls;
+    }
+
+    struct Sample
+    {
+        double sim_s;
+        double wall_s;
+        uint64_t events;        // run over the interval
+        double rate;            // events per wall second over the interval
+        uint64_t depth;         // pending at the end of the interval
+        uint64_t max_depth;     // most pending during the interval
+    };
+
+    struct Trial
+    {
+        double wall_s;
+        uint64_t events;
+    };
+
+    // total events scheduled by one handler class
+    struct HandlerCount
+    {
+        string handler;
+        uint64_t events;
+    };
+};
+
+/*
+ * a scheduler that passes everything to one of ns-3's and counts on the
+ * way. there is one simulator, so the last one made is the one counted
+ */
+class ProfilingScheduler : public Scheduler
+{
+    private:
+        string inner_type;
+        Ptr<Scheduler> inner;
+
+        uint64_t scheduled, run, removed;
+        uint64_t depth, peak;
+        // keyed by the type_info's address, merged by name when reported
+        unordered_map<const type_info *, uint64_t> by_type;
+
+        static ProfilingScheduler *&instance(void)
+        {
+            static ProfilingScheduler *p = NULL;
+            return p;
+        }
+
+    protected:
+        void NotifyConstructionCompleted(void)
+        {
+            ObjectFactory factory;
+            factory.SetTypeId(this->inner_type);
+            this->inner = factory.Create<Scheduler>();
+            Scheduler::NotifyConstructionCompleted();
+        }
+
+    public:
+        static TypeId GetTypeId(void)
+        {
+            static TypeId tid = TypeId("ProfilingScheduler")
+                .SetParent<Scheduler>()
+                .AddConstructor<ProfilingScheduler>()
+                .AddAttribute("Inner", "the scheduler events are passed to", StringValue("ns3::MapScheduler"),
+                              MakeStringAccessor(&ProfilingScheduler::inner_type), MakeStringChecker());
+            return tid;
+        }
+
+        ProfilingScheduler() : scheduled(0), run(0), removed(0), depth(0), peak(0) { instance() = this; }
+        ~ProfilingScheduler() { if(instance() == this) { instance() = NULL; } }
+
+        static ProfilingScheduler *current(void) { return instance(); }
+
+        void Insert(const Scheduler::Event &ev)
+        {
+            this->inner->Insert(ev);
+            this->by_type[&typeid(*ev.impl)]++;
+            this->scheduled++;
+            if(++this->depth > this->peak) { this->peak = this->depth; }
+        }
+
+        bool IsEmpty(void) const { return this->inner->IsEmpty(); }
+        Scheduler::Event PeekNext(void) const { return this->inner->PeekNext(); }
+
+        Scheduler::Event RemoveNext(void)
+        {
+            this->run++;
+            this->depth--;
+            return this->inner->RemoveNext();
+        }
+
+        void Remove(const Scheduler::Event &ev)
+        {
+            this->removed++;
+            this->depth--;
+            this->inner->Remove(ev);
+        }
+
+        uint64_t get_scheduled(void) const { return this->scheduled; }
+        uint64_t get_run(void) const { return this->run; }
+        uint64_t get_depth(void) const { return this->depth; }
+
+        // most pending since the last call
+        uint64_t take_peak(void)
+        {
+            uint64_t p = this->peak;
+            this->peak = this->depth;
+            return p;
+        }
+
+        // events scheduled per handler class, most first
+        vector<simprofile::HandlerCount> handlers(void) const
+        {
+            unordered_map<string, uint64_t> merged;
+            for(const auto &t: this->by_type) { merged[simprofile::handler(*t.first)] += t.second; }
+
+            vector<simprofile::HandlerCount> out;
+            for(const auto &m: merged) { out.push_back(simprofile::HandlerCount{m.first, m.second}); }
+            sort(out.begin(), out.end(), [](const simprofile::HandlerCount &a, const simprofile::HandlerCount &b)
+            {
+                return a.events > b.events;
+            });
+            return out;
+        }
+};
+
+namespace simprofile
+{
+    /*
+     * run the simulator on a scheduler by short name, wrapped in the
+     * profiling one if profile is set. false for an unknown name
+     */
+    inline bool use(const string &name, bool profile)
+    {
+        string type = type_name(name);
+        if(type.empty()) { return false; }
+
+        ObjectFactory factory;
+        if(profile)
+        {
+            factory.SetTypeId(ProfilingScheduler::GetTypeId());
+            factory.Set("Inner", StringValue(type));
+        }
+        else { factory.SetTypeId(type); }
+        Simulator::SetScheduler(factory);
+        return true;
+    }
+
+    // samples the profiling scheduler every interval of simulated time
+    class Profiler
+    {
+        private:
+            string filename;
+            Time interval;
+            vector<Sample> samples;
+            uint64_t start_ns, last_ns;
+            uint64_t last_run;
+            EventId sample_event;
+
+            void sample(void)
+            {
+                ProfilingScheduler *s = ProfilingScheduler::current();
+                if(!s) { return; }
+
+                uint64_t now = instrument::now_ns();
+                double wall = (now - this->last_ns)/1e9;
+                Sample x;
+                x.sim_s     = Simulator::Now().GetSeconds();
+                x.wall_s    = (now - this->start_ns)/1e9;
+                x.events    = s->get_run() - this->last_run;
+                x.rate      = wall > 0 ? x.events/wall : 0;
+                x.depth     = s->get_depth();
+                x.max_depth = s->take_peak();
+                this->samples.push_back(x);
+
+                this->last_ns  = now;
+                this->last_run = s->get_run();
+            }
+
+            void tick(void)
+            {
+                this->sample();
+                this->sample_event = Simulator::Schedule(this->interval, &Profiler::tick, this);
+            }
+
+        public:
+            Profiler(string filename, Time interval) : filename(filename), interval(interval), start_ns(0), last_ns(0),
+                                                       last_run(0) {}
+
+            // call once the scheduler is set, before the run
+            void start(void)
+            {
+                this->start_ns = this->last_ns = instrument::now_ns();
+                this->sample_event = Simulator::Schedule(this->interval, &Profiler::tick, this);
+            }
+
+            // the partial interval at the end of the run, and the CSV
+            bool finish(void)
+            {
+                if(this->sample_event.IsRunning()) { Simulator::Cancel(this->sample_event); }
+                this->sample();
+
+                FILE *out = fopen(this->filename.c_str(), "w");
+                if(!out) { return false; }
+                fprintf(out, "sim_s,wall_s,events,events_per_s,queue_depth,max_queue_depth\n");
+                for(const Sample &x: this->samples)
+                {
+                    fprintf(out, "%.3f,%.6f,%llu,%.0f,%llu,%llu\n", x.sim_s, x.wall_s, (unsigned long long)x.events,
+                            x.rate, (unsigned long long)x.depth, (unsigned long long)x.max_depth);
+                }
+                return fclose(out) == 0;
+            }
+
+            const vector<Sample> &get_samples(void) const { return this->samples; }
+
+            void report(ostream &out, size_t top = 8)
+            {
+                ProfilingScheduler *s = ProfilingScheduler::current();
+                if(!s || this->samples.empty()) { return; }
+
+                uint64_t max_depth = 0;
+                double depth_sum = 0;
+                for(const Sample &x: this->samples)
+                {
+                    max_depth = max(max_depth, x.max_depth);
+                    depth_sum += x.depth;
+                }
+                const Sample &last = this->samples.back();
+                out << "events: " << s->get_run() << " run in " << last.wall_s << "s (" << s->get_run()/last.wall_s
+                    << "/s) over " << last.sim_s << " simulated seconds, queue depth mean "
+                    << depth_sum/this->samples.size() << " max " << max_depth << endl;
+
+                vector<HandlerCount> handlers = s->handlers();
+                for(size_t i=0; i<min(top, handlers.size()); i++)
+                {
+                    out << "events: " << handlers[i].handler << " " << handlers[i].events << " ("
+                        << 100.0*handlers[i].events/max<uint64_t>(1, s->get_scheduled()) << "%)" << endl;
+                }
+            }
+    };
+};
+#endif
@@ -0,0 +1,273 @@
+/*
+ * Result sink header file
+ *
+ * writes integer result series (live servers, transitions, schedules) to
+ * a file through large buffers instead of a stream flushed per line. the
+ * data goes to a temporary file next to the target which is renamed over
+ * it on close, so readers see the old file or the whole new one, never a
+ * mix of runs. formatting and writing can be split over a background
+ * thread that writes one buffer while the caller fills the next
+ *
+ *   TEXT     one decimal value per line, what export_data() wrote
+ *   BINARY   "ELBINT32", uint64 count, then count little endian int32
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef SINK_H
+#define SINK_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+namespace sink
+{
+    enum Encoding { TEXT, BINARY };
+
+    static const char BINARY_MAGIC[8] = {'E', 'L', 'B', 'I', 'N', 'T', '3', '2'};
+    static const size_t BINARY_HEADER = 16;
+
+    // write all of it, false on error
+    inline bool write_all(int fd, const char *p, size_t n)
+    {
+        while(n > 0)
+        {
+            ssize_t w = ::write(fd, p, n);
+            if(w < 0)
+            {
+                if(errno == EINTR) { continue; }
+                return false;
+            }
+            p += w;
+            n -= size_t(w);
+        }
+        return true;
+    }
+
+    // decimal digits of v ending at end, returns the first character
+    inline char *format_int(int32_t v, char *end)
+    {
+        uint32_t u = v < 0 ? 0u - uint32_t(v) : uint32_t(v);
+        do { *--end = char('0' + u % 10); u /= 10; } while(u != 0);
+        if(v < 0) { *--end = '-'; }
+        return end;
+    }
+
+    class ResultSink
+    {
+        private:
+            string path, tmp_path;
+            Encoding encoding;
+            bool async, durable;
+            size_t capacity;
+            int fd;
+            bool failed;
+            uint64_t count;
+
+            vector<char> buffer;        // capacity bytes, the first used filled
+            size_t used;
+
+            // background writer: full buffers queued for it, empty ones
+            // handed back, at most two in flight
+            thread writer;
+            mutex lock;
+            condition_variable changed;
+            deque<vector<char>> pending;
+            vector<vector<char>> spare;
+            bool stopping;
+
+            void write_loop(void)
+            {
+                unique_lock<mutex> guard(this->lock);
+                while(true)
+                {
+                    this->changed.wait(guard, [this]() { return this->stopping || !this->pending.empty(); });
+                    if(this->pending.empty()) { return; }
+
+                    vector<char> full = move(this->pending.front());
+                    guard.unlock();
+                    bool ok = write_all(this->fd, full.data(), full.size());
+                    guard.lock();
+
+                    this->pending.pop_front();
+                    if(!ok) { this->failed = true; }
+                    this->spare.push_back(move(full));
+                    this->changed.notify_all();
+                }
+            }
+
+            void flush_buffer(void)
+            {
+                if(this->used == 0) { return; }
+                if(!this->async)
+                {
+                    if(!write_all(this->fd, this->buffer.data(), this->used)) { this->failed = true; }
+                    this->used = 0;
+                    return;
+                }
+
+                // the writer takes the filled part, the caller gets an empty buffer back
+                unique_lock<mutex> guard(this->lock);
+                this->changed.wait(guard, [this]() { return this->pending.size() < 2; });
+                this->buffer.resize(this->used);
+                this->pending.push_back(move(this->buffer));
+                if(this->spare.empty()) { this->buffer = vector<char>(); }
+                else { this->buffer = move(this->spare.back()); this->spare.pop_back(); }
+                this->changed.notify_all();
+                guard.unlock();
+
+                this->buffer.resize(this->capacity);
+                this->used = 0;
+            }
+
+            void append(const char *p, size_t n)
+            {
+                while(n > 0)
+                {
+                    if(this->used == this->capacity) { this->flush_buffer(); }
+                    size_t m = min(n, this->capacity - this->used);
+                    memcpy(this->buffer.data() + this->used, p, m);
+                    this->used += m;
+                    p += m;
+                    n -= m;
+                }
+            }
+
+        public:
+            /*
+             * nothing is visible at filename until close(). durable also
+             * fsyncs the data before the rename
+             */
+            ResultSink(const string &filename, Encoding encoding = TEXT, bool async = false, size_t capacity = 4 << 20,
+                       bool durable = false) :
+                path(filename), encoding(encoding), async(async), durable(durable),
+                capacity(capacity < 64 ? 64 : capacity), failed(false), count(0), used(0), stopping(false)
+            {
+                this->tmp_path = filename + ".tmp." + to_string(getpid());
+                this->fd = open(this->tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if(this->fd < 0) { this->failed = true; return; }
+
+                this->buffer.resize(this->capacity);
+                if(encoding == BINARY)
+                {
+                    // the count is patched in on close
+                    char header[BINARY_HEADER] = {0};
+                    memcpy(header, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+                    this->append(header, sizeof(header));
+                }
+                if(async) { this->writer = thread(&ResultSink::write_loop, this); }
+            }
+
+            ResultSink(const ResultSink &) = delete;
+            ResultSink &operator=(const ResultSink &) = delete;
+
+            ~ResultSink() { this->close(); }
+
+            bool valid(void) const { return this->fd >= 0 && !this->failed; }
+
+            void write(const int32_t *values, size_t n)
+            {
+                if(this->fd < 0) { return; }
+                this->count += n;
+
+                if(this->encoding == BINARY)
+                {
+                    // the targets are little endian, int32 is written as is
+                    this->append(reinterpret_cast<const char *>(values), n*sizeof(int32_t));
+                    return;
+                }
+
+                // at most 11 characters and a newline per value
+                char digits[16];
+                digits[sizeof(digits) - 1] = '\n';
+                for(size_t i=0; i<n; i++)
+                {
+                    if(this->used + sizeof(digits) > this->capacity) { this->flush_buffer(); }
+                    char *first = format_int(values[i], digits + sizeof(digits) - 1);
+                    size_t len = digits + sizeof(digits) - first;
+                    memcpy(this->buffer.data() + this->used, first, len);
+                    this->used += len;
+                }
+            }
+
+            void write(const vector<int> &values) { this->write(values.data(), values.size()); }
+
+            /*
+             * write out what is buffered and move the file into place.
+             * false, and the old file left alone, if anything failed
+             */
+            bool close(void)
+            {
+                if(this->fd < 0) { return false; }
+
+                this->flush_buffer();
+                if(this->async)
+                {
+                    {
+                        lock_guard<mutex> guard(this->lock);
+                        this->stopping = true;
+                    }
+                    this->changed.notify_all();
+                    this->writer.join();
+                    this->async = false;
+                }
+
+                if(this->encoding == BINARY && !this->failed)
+                {
+                    uint64_t n = this->count;
+                    if(pwrite(this->fd, &n, sizeof(n), sizeof(BINARY_MAGIC)) != ssize_t(sizeof(n))) { this->failed = true; }
+                }
+                if(this->durable && !this->failed && fsync(this->fd) != 0) { this->failed = true; }
+                if(::close(this->fd) != 0) { this->failed = true; }
+                this->fd = -1;
+
+                if(!this->failed && rename(this->tmp_path.c_str(), this->path.c_str()) != 0) { this->failed = true; }
+                if(this->failed) { unlink(this->tmp_path.c_str()); }
+                return !this->failed;
+            }
+
+            uint64_t size(void) const { return this->count; }
+    };
+
+    // one series to one file, replacing it
+    inline bool write_file(const string &filename, const vector<int> &values, Encoding encoding = TEXT,
+                           bool async = false)
+    {
+        ResultSink out(filename, encoding, async);
+        out.write(values);
+        return out.close();
+    }
+
+    // read a BINARY file back, empty if it is not one
+    inline vector<int> read_binary(const string &filename)
+    {
+        vector<int> values;
+        FILE *f = fopen(filename.c_str(), "rb");
+        if(f == NULL) { return values; }
+
+        char header[BINARY_HEADER];
+        uint64_t n = 0;
+        if(fread(header, 1, sizeof(header), f) == sizeof(header) && memcmp(header, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0)
+        {
+            memcpy(&n, header + sizeof(BINARY_MAGIC), sizeof(n));
+            values.resize(n);
+            if(fread(values.data(), sizeof(int32_t), n, f) != n) { values.clear(); }
+        }
+        fclose(f);
+        return values;
+    }
+};
+#endif
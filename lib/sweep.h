@@ -0,0 +1,159 @@
+/*
+ * Parameter sweep header file
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "kernels.h"
+#include "online.h"
+#include "optimal.h"
+#include "parallel.h"
+
+using namespace std;
+
+namespace sweep
+{
+    enum Policy
+    {
+        OFFLINE,    // offline_lb2
+        ONLINE,     // online_lb
+        OPTIMAL     // offline_opt
+    };
+
+    inline const char *policy_name(Policy p)
+    {
+        return p == OFFLINE ? "offline" : p == ONLINE ? "online" : "optimal";
+    }
+
+    struct Point
+    {
+        Policy policy;
+        double threshold;
+        double kappa;       // online only
+        int tau;            // online only
+        double k;           // weight of a transition in the cost
+        int servers;
+    };
+
+    struct Row
+    {
+        Point point;
+        uint64_t server_seconds;
+        uint64_t transitions;
+        double dropped;
+        double cost;        // server_seconds + k*transitions
+    };
+
+    struct Grid
+    {
+        vector<double> thresholds;
+        vector<double> kappas;
+        vector<int> taus;
+        vector<double> ks;
+        vector<int> servers;
+    };
+
+    // every combination, offline and optimal points do not depend on kappa and tau
+    inline vector<Point> expand(const Grid &g)
+    {
+        vector<Point> points;
+        for(int n: g.servers)
+            for(double thr: g.thresholds)
+                for(double k: g.ks)
+                {
+                    points.push_back({OFFLINE, thr, 0.0, 0, k, n});
+                    points.push_back({OPTIMAL, thr, 0.0, 0, k, n});
+                    for(double kappa: g.kappas)
+                        for(int tau: g.taus) { points.push_back({ONLINE, thr, kappa, tau, k, n}); }
+                }
+        return points;
+    }
+
+    /*
+     * evaluate one point over the trace without materialising its series:
+     * offline m_t is produced a kernel block at a time into a stack buffer
+     */
+    inline Row evaluate(const vector<double> &load, const Point &p)
+    {
+        Row row = {p, 0, 0, 0.0, 0.0};
+
+        if(p.policy == OFFLINE)
+        {
+            int m[kernels::BLOCK];
+            int prev = -1;
+            for(size_t first=0; first<load.size(); first+=kernels::BLOCK)
+            {
+                size_t len = min(kernels::BLOCK, load.size() - first);
+                kernels::provision(load.data() + first, len, p.threshold, p.servers, 1, m);
+
+                for(size_t i=0; i<len; i++)
+                {
+                    row.server_seconds += m[i];
+                    // m_t is clamped to the fleet, load above what it carries is dropped
+                    row.dropped += max(0.0, load[first + i] - m[i]*p.threshold/p.servers);
+                    if(prev >= 0) { row.transitions += abs(m[i] - prev); }
+                    prev = m[i];
+                }
+            }
+        }
+        else if(p.policy == OPTIMAL)
+        {
+            optimal::Schedule sched = optimal::solve(load, p.threshold, p.servers, p.k);
+            row.server_seconds = sched.server_seconds;
+            row.transitions    = sched.transitions;
+            for(size_t t=0; t<load.size(); t++)
+            {
+                row.dropped += max(0.0, load[t] - sched.servers[t]*p.threshold/p.servers);
+            }
+        }
+        else
+        {
+            online::OnlineBalancer engine(p.servers, p.threshold, p.kappa, p.tau);
+            for(double l: load) { engine.push(l); }
+
+            const online::Totals &t = engine.get_totals();
+            row.server_seconds = t.server_seconds;
+            row.transitions    = t.transitions;
+            row.dropped        = t.dropped;
+        }
+
+        row.cost = double(row.server_seconds) + p.k*row.transitions;
+        return row;
+    }
+
+    // the trace is shared read-only by every worker
+    inline vector<Row> run(const vector<double> &load, const vector<Point> &points, unsigned threads)
+    {
+        vector<Row> rows(points.size());
+        parallel::parallel_for(points.size(), threads, [&](size_t i) { rows[i] = evaluate(load, points[i]); });
+        return rows;
+    }
+
+    inline bool write_csv(const string &filename, const vector<Row> &rows)
+    {
+        FILE *f = fopen(filename.c_str(), "w");
+        if(!f) { return false; }
+
+        fprintf(f, "policy,threshold,kappa,tau,k,servers,server_seconds,transitions,dropped,cost\n");
+        for(const Row &r: rows)
+        {
+            fprintf(f, "%s,%g,%g,%d,%g,%d,%llu,%llu,%.9g,%.9g\n", policy_name(r.point.policy),
+                    r.point.threshold, r.point.kappa, r.point.tau, r.point.k, r.point.servers,
+                    (unsigned long long)r.server_seconds, (unsigned long long)r.transitions, r.dropped, r.cost);
+        }
+
+        bool ok = !ferror(f);
+        fclose(f);
+        return ok;
+    }
+};
+#endif
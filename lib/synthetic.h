@@ -0,0 +1,156 @@
+/*
+ * Synthetic trace header file
+ *
+ * deterministic load traces for benchmarks and tests, in the normalised
+ * units load_data() returns (1.0 is the whole CDN at its threshold). the
+ * same shape and seed give the same samples however they are split into
+ * chunks, so traces too long for memory can be generated piece by piece
+ *
+ *   DIURNAL      daily sine with noise
+ *   BURSTY       lower daily base with on/off bursts lasting minutes
+ *   FLASH_CROWD  quiet base with rare ramps past full load that decay
+ *                over half an hour
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+
+using namespace std;
+
+namespace synthetic
+{
+    enum Shape { DIURNAL, BURSTY, FLASH_CROWD };
+
+    inline const char *shape_name(Shape s)
+    {
+        switch(s)
+        {
+            case DIURNAL: return "diurnal";
+            case BURSTY:  return "bursty";
+            default:      return "flash-crowd";
+        }
+    }
+
+    class Generator
+    {
+        private:
+            Shape shape;
+            mt19937_64 rng;
+            uint64_t t;             // seconds generated so far
+
+            // bursts: on/off state and the current burst's height
+            bool burst_on;
+            double burst;
+
+            // flash crowds: height above the base, rising until peak
+            double flash, flash_peak;
+
+            double uniform(void) { return (this->rng() >> 11)*(1.0/9007199254740992.0); }
+
+            double noise(double sd)
+            {
+                // Irwin-Hall, close enough to normal and cheap
+                double s = this->uniform() + this->uniform() + this->uniform() + this->uniform() - 2.0;
+                return s*sd*1.7320508075688772;
+            }
+
+            double day(double amplitude, double mean)
+            {
+                return mean + amplitude*sin(double(this->t % 86400)*(2*M_PI/86400) - M_PI/2);
+            }
+
+            double next(void)
+            {
+                double l;
+                switch(this->shape)
+                {
+                    case DIURNAL:
+                        l = this->day(0.4, 0.45) + this->noise(0.03);
+                        break;
+
+                    case BURSTY:
+                        // bursts start about every 20 minutes and last about 3
+                        if(this->burst_on ? this->uniform() < 1.0/180 : this->uniform() < 1.0/1200)
+                        {
+                            this->burst_on = !this->burst_on;
+                            if(this->burst_on) { this->burst = 0.2 + 0.3*this->uniform(); }
+                        }
+                        l = this->day(0.2, 0.3) + (this->burst_on ? this->burst : 0) + this->noise(0.05);
+                        break;
+
+                    default:
+                        // a flash crowd about every 6 hours, a minute to peak
+                        if(this->flash_peak == 0 && this->uniform() < 1.0/21600)
+                        {
+                            this->flash_peak = 0.7 + 0.5*this->uniform();
+                        }
+                        if(this->flash_peak > 0)
+                        {
+                            this->flash += this->flash_peak/60;
+                            if(this->flash >= this->flash_peak) { this->flash = this->flash_peak; this->flash_peak = 0; }
+                        }
+                        else { this->flash *= 0.99944; }   // exp(-1/1800)
+                        l = this->day(0.05, 0.2) + this->flash + this->noise(0.02);
+                        break;
+                }
+
+                this->t++;
+                return l < 0 ? 0 : l;
+            }
+
+        public:
+            Generator(Shape shape, uint64_t seed) : shape(shape), rng(seed), t(0), burst_on(false), burst(0), flash(0),
+                flash_peak(0) {}
+
+            // the next n samples of the trace
+            void fill(double *out, size_t n)
+            {
+                for(size_t i=0; i<n; i++) { out[i] = this->next(); }
+            }
+
+            vector<double> take(size_t n)
+            {
+                vector<double> out(n);
+                this->fill(out.data(), n);
+                return out;
+            }
+
+            uint64_t get_time(void) const { return this->t; }
+    };
+
+    /*
+     * write n samples as a trace main() can load, one request count per
+     * line at the given capacity. false if the file cannot be written
+     */
+    inline bool write_csv(const string &filename, Shape shape, uint64_t seed, size_t n, double capacity)
+    {
+        FILE *f = fopen(filename.c_str(), "w");
+        if(f == NULL) { return false; }
+
+        Generator gen(shape, seed);
+        vector<double> chunk(1 << 16);
+        vector<char> buffer(chunk.size()*24);
+
+        for(size_t done=0; done<n; done+=chunk.size())
+        {
+            size_t m = min(chunk.size(), n - done);
+            gen.fill(chunk.data(), m);
+
+            size_t len = 0;
+            for(size_t i=0; i<m; i++) { len += sprintf(buffer.data() + len, "%lld\n", (long long)llround(chunk[i]*capacity)); }
+            fwrite(buffer.data(), 1, len, f);
+        }
+        return fclose(f) == 0;
+    }
+};
+#endif
@@ -0,0 +1,260 @@
+/*
+ * Flow telemetry header file
+ *
+ * per-cluster, per-interval throughput, delay and loss from a FlowMonitor.
+ * every interval one event reads the monitor's flow stats, subtracts what
+ * each flow had at the previous interval and adds the difference to its
+ * destination cluster's counters, then writes one record per cluster and
+ * clears them. counters are fixed arrays sized at install time, nothing is
+ * allocated per packet or per interval
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+
+#include "network.h"
+#include "ns3/flow-monitor-helper.h"
+#include "ns3/ipv4-flow-classifier.h"
+
+using namespace ns3;
+using namespace std;
+
+// one cluster over one interval, also the binary record layout
+struct ClusterSample
+{
+    uint32_t interval;
+    uint32_t cluster;
+    uint64_t tx_packets, rx_packets;
+    uint64_t tx_bytes, rx_bytes;
+    uint64_t lost;
+    int64_t delay_ns;           // summed over the received packets
+};
+
+struct TelemetryStats
+{
+    uint64_t intervals;
+    uint64_t records;
+    uint64_t flows;
+    double sample_seconds;      // wall time spent in the interval events
+};
+
+class Telemetry
+{
+    private:
+        // what a flow had at the end of the previous interval
+        struct FlowMark
+        {
+            int cluster;
+            uint64_t tx_packets, rx_packets, tx_bytes, rx_bytes, lost;
+            int64_t delay_ns;
+        };
+
+        double interval;
+        bool binary;
+        FILE *out;
+        bool failed;                // the file could not be opened
+        Time last;                  // end of the last interval written
+
+        FlowMonitorHelper helper;
+        Ptr<FlowMonitor> monitor;
+        Ptr<Ipv4FlowClassifier> classifier;
+
+        unordered_map<uint32_t, int> host_cluster;  // rack host address to cluster
+        vector<FlowMark> marks;                     // indexed by flow id
+        vector<ClusterSample> samples;              // indexed by cluster
+        ClusterSample total;                        // every cluster, every interval
+        TelemetryStats stats;
+
+        int cluster_of(FlowId id)
+        {
+            Ipv4FlowClassifier::FiveTuple t = this->classifier->FindFlow(id);
+            auto it = this->host_cluster.find(t.destinationAddress.Get());
+            return it == this->host_cluster.end() ? -1 : it->second;
+        }
+
+        void write(void)
+        {
+            for(const ClusterSample &s: this->samples)
+            {
+                this->total.tx_packets += s.tx_packets;
+                this->total.rx_packets += s.rx_packets;
+                this->total.tx_bytes   += s.tx_bytes;
+                this->total.rx_bytes   += s.rx_bytes;
+                this->total.lost       += s.lost;
+                this->total.delay_ns   += s.delay_ns;
+            }
+            this->stats.records += this->samples.size();
+            if(this->out == NULL) { return; }
+
+            if(this->binary)
+            {
+                fwrite(this->samples.data(), sizeof(ClusterSample), this->samples.size(), this->out);
+            }
+            else
+            {
+                for(const ClusterSample &s: this->samples)
+                {
+                    fprintf(this->out, "%u,%u,%llu,%llu,%llu,%llu,%llu,%lld\n", s.interval, s.cluster,
+                            (unsigned long long)s.tx_packets, (unsigned long long)s.rx_packets,
+                            (unsigned long long)s.tx_bytes, (unsigned long long)s.rx_bytes,
+                            (unsigned long long)s.lost, (long long)s.delay_ns);
+                }
+            }
+        }
+
+        void collect(void)
+        {
+            auto start = chrono::steady_clock::now();
+
+            this->monitor->CheckForLostPackets();
+            const FlowMonitor::FlowStatsContainer &flows = this->monitor->GetFlowStats();
+
+            for(ClusterSample &s: this->samples)
+            {
+                s.interval = uint32_t(this->stats.intervals);
+                s.tx_packets = s.rx_packets = s.tx_bytes = s.rx_bytes = s.lost = 0;
+                s.delay_ns = 0;
+            }
+
+            for(auto &f: flows)
+            {
+                // flow ids are handed out in order from 1
+                if(f.first >= this->marks.size())
+                {
+                    size_t from = this->marks.size();
+                    this->marks.resize(f.first + 1);
+                    for(size_t id=from; id<this->marks.size(); id++)
+                    {
+                        this->marks[id] = FlowMark{this->cluster_of(FlowId(id)), 0, 0, 0, 0, 0, 0};
+                    }
+                }
+
+                FlowMark &m = this->marks[f.first];
+                const FlowMonitor::FlowStats &now = f.second;
+                if(m.cluster >= 0)
+                {
+                    ClusterSample &s = this->samples[m.cluster];
+                    s.tx_packets += now.txPackets - m.tx_packets;
+                    s.rx_packets += now.rxPackets - m.rx_packets;
+                    s.tx_bytes   += now.txBytes - m.tx_bytes;
+                    s.rx_bytes   += now.rxBytes - m.rx_bytes;
+                    s.lost       += now.lostPackets - m.lost;
+                    s.delay_ns   += now.delaySum.GetNanoSeconds() - m.delay_ns;
+                }
+                m.tx_packets = now.txPackets;
+                m.rx_packets = now.rxPackets;
+                m.tx_bytes   = now.txBytes;
+                m.rx_bytes   = now.rxBytes;
+                m.lost       = now.lostPackets;
+                m.delay_ns   = now.delaySum.GetNanoSeconds();
+            }
+
+            this->write();
+            this->stats.intervals++;
+            this->stats.flows = flows.size();
+            this->stats.sample_seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            this->last = Simulator::Now();
+        }
+
+        void sample(void)
+        {
+            this->collect();
+            Simulator::Schedule(Seconds(this->interval), &Telemetry::sample, this);
+        }
+
+    public:
+        /*
+         * binary output writes ClusterSample records, anything else CSV. with
+         * no filename nothing is written and only the totals are kept
+         */
+        Telemetry(string filename, double interval, bool binary = false) :
+            interval(interval > 0 ? interval : 1), binary(binary), out(NULL), failed(false)
+        {
+            this->stats = TelemetryStats{0, 0, 0, 0};
+            this->total = ClusterSample{0, 0, 0, 0, 0, 0, 0, 0};
+            if(filename.empty()) { return; }
+
+            this->out = fopen(filename.c_str(), binary ? "wb" : "w");
+            if(this->out == NULL)
+            {
+                cerr << "Cannot open telemetry file " << filename << endl;
+                this->failed = true;
+                return;
+            }
+
+            // one interval of every cluster is a few KB, let stdio batch them
+            setvbuf(this->out, NULL, _IOFBF, 1 << 20);
+            if(!binary) { fprintf(this->out, "interval,cluster,tx_packets,rx_packets,tx_bytes,rx_bytes,lost,delay_ns\n"); }
+        }
+
+        ~Telemetry() { this->close(); }
+
+        bool valid(void) const { return !this->failed; }
+
+        /*
+         * monitor the origin and the rack hosts, call after the addresses
+         * are assigned. the first interval ends interval seconds into the
+         * simulation. loss is only right when both ends of every flow are
+         * in this process, a distributed run must not use it
+         */
+        void install(Network &cdn)
+        {
+            if(!this->valid()) { return; }
+
+            NodeContainer nodes;
+            if(cdn.is_local(cdn.get_origin())) { nodes.Add(cdn.get_origin()); }
+
+            for(Server *rack: cdn.get_server_nodes())
+            {
+                // node 0 of a rack is its TOR
+                for(uint32_t i=1; i<rack->getNodes().GetN(); i++)
+                {
+                    this->host_cluster[rack->getIPContainer().GetAddress(i).Get()] = rack->getClusterID();
+                    if(cdn.is_local(rack->getNodes().Get(i))) { nodes.Add(rack->getNodes().Get(i)); }
+                }
+            }
+
+            this->monitor = this->helper.Install(nodes);
+            this->classifier = DynamicCast<Ipv4FlowClassifier>(this->helper.GetClassifier());
+
+            this->samples.resize(cdn.get_clusters());
+            for(size_t c=0; c<this->samples.size(); c++) { this->samples[c].cluster = uint32_t(c); }
+
+            Simulator::Schedule(Seconds(this->interval), &Telemetry::sample, this);
+        }
+
+        // write the partial interval the simulation stopped in, call after Run()
+        void finish(void)
+        {
+            if(this->valid() && this->monitor && Simulator::Now() > this->last) { this->collect(); }
+            this->close();
+        }
+
+        void close(void)
+        {
+            if(this->out != NULL) { fclose(this->out); this->out = NULL; }
+        }
+
+        TelemetryStats get_stats(void) const { return this->stats; }
+        const ClusterSample &get_total(void) const { return this->total; }
+
+        void report(ostream &out)
+        {
+            out << "telemetry: " << this->stats.intervals << " intervals, " << this->stats.records << " records, "
+                << this->stats.flows << " flows, " << this->stats.sample_seconds*1000 << "ms sampling ("
+                << (this->stats.intervals ? this->stats.sample_seconds*1e6/this->stats.intervals : 0)
+                << "us per interval)" << endl;
+        }
+};
+#endif
@@ -0,0 +1,234 @@
+/*
+ * Decision timeline header file
+ *
+ * a per-second series of live servers (m_t) kept without one int per
+ * second. m_t is bounded by the fleet size, so values are one, two or
+ * four bytes wide, chosen from the largest value the series can hold. a
+ * series that changes rarely is kept as runs, a start second and a value;
+ * one that changes nearly every second (offline_lb on a noisy trace)
+ * would be larger as runs, and is kept as a plain narrow array instead
+ *
+ * every 64th run (or second) carries the server-seconds and transitions
+ * before it, so a query is a binary search over the run starts and a
+ * scan of at most 64 entries, never an expansion of the series
+ *
+ *   at(t)                  m_t
+ *   server_seconds(a, b)   sum of m_t over [a, b)
+ *   transitions(a, b)      sum of |m_t - m_(t-1)| for a < t < b, the
+ *                          changes between seconds both inside [a, b)
+ *
+ * built in one pass with push(), a series is at most 2^32 seconds long
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+namespace timeline
+{
+    static const size_t STRIDE = 64;     // entries per checkpoint
+
+    class Timeline
+    {
+        private:
+            int width;                      // bytes per value
+            bool dense;                     // one value per second, no starts
+            uint64_t length;                // seconds pushed
+            vector<uint32_t> starts;        // first second of each run
+            vector<uint8_t> values;         // width bytes per entry
+            vector<uint64_t> seconds;       // server-seconds before every STRIDE-th entry
+            vector<uint64_t> changes;       // transitions up to and including every STRIDE-th entry's start
+            int64_t last;
+            uint64_t total_seconds, total_changes;
+
+            void put(int64_t v)
+            {
+                size_t at = this->values.size();
+                this->values.resize(at + this->width);
+                if(this->width == 1) { this->values[at] = uint8_t(v); }
+                else if(this->width == 2) { uint16_t x = uint16_t(v); memcpy(&this->values[at], &x, 2); }
+                else { uint32_t x = uint32_t(v); memcpy(&this->values[at], &x, 4); }
+            }
+
+            int64_t value(size_t e) const
+            {
+                const uint8_t *p = this->values.data() + e*this->width;
+                if(this->width == 1) { return *p; }
+                if(this->width == 2) { uint16_t x; memcpy(&x, p, 2); return x; }
+                uint32_t x;
+                memcpy(&x, p, 4);
+                return x;
+            }
+
+            size_t entries(void) const { return this->values.size()/this->width; }
+            uint64_t start(size_t e) const { return this->dense ? e : this->starts[e]; }
+            uint64_t end(size_t e) const { return e + 1 < this->entries() ? this->start(e + 1) : this->length; }
+
+            // entry holding second t, t < length
+            size_t entry_of(uint64_t t) const
+            {
+                if(this->dense) { return size_t(t); }
+                return size_t(upper_bound(this->starts.begin(), this->starts.end(), uint32_t(t)) - this->starts.begin()) - 1;
+            }
+
+            // a new entry starting at the current length
+            void open(int64_t v)
+            {
+                if(this->last >= 0) { this->total_changes += uint64_t(llabs(v - this->last)); }
+                if(this->entries() % STRIDE == 0)
+                {
+                    this->seconds.push_back(this->total_seconds);
+                    this->changes.push_back(this->total_changes);
+                }
+                if(!this->dense) { this->starts.push_back(uint32_t(this->length)); }
+                this->put(v);
+                this->last = v;
+            }
+
+            /*
+             * runs as large as the array would be, from here on a value per
+             * second. only once enough has been seen to tell
+             */
+            void densify(void)
+            {
+                vector<uint32_t> runs;
+                runs.swap(this->starts);
+                vector<uint8_t> run_values;
+                run_values.swap(this->values);
+                uint64_t n = this->length;
+
+                this->dense = true;
+                this->seconds.clear();
+                this->changes.clear();
+                this->last = -1;
+                this->length = this->total_seconds = this->total_changes = 0;
+                this->values.reserve(n*this->width);
+
+                const uint8_t *p = run_values.data();
+                for(size_t r=0; r<runs.size(); r++, p+=this->width)
+                {
+                    uint64_t to = r + 1 < runs.size() ? runs[r+1] : n;
+                    int64_t v = this->width == 1 ? *p : 0;
+                    if(this->width == 2) { uint16_t x; memcpy(&x, p, 2); v = x; }
+                    else if(this->width == 4) { uint32_t x; memcpy(&x, p, 4); v = x; }
+                    for(uint64_t t=runs[r]; t<to; t++) { this->push(uint32_t(v)); }
+                }
+            }
+
+            // server-seconds over [0, t)
+            uint64_t seconds_before(uint64_t t) const
+            {
+                if(t == 0) { return 0; }
+                size_t e = this->entry_of(t - 1);
+                size_t c = e/STRIDE;
+                uint64_t sum = this->seconds[c];
+                for(size_t i=c*STRIDE; i<e; i++) { sum += uint64_t(this->value(i))*(this->end(i) - this->start(i)); }
+                return sum + uint64_t(this->value(e))*(t - this->start(e));
+            }
+
+            // transitions at seconds 1..t
+            uint64_t changes_through(uint64_t t) const
+            {
+                size_t e = this->entry_of(t);
+                size_t c = e/STRIDE;
+                uint64_t sum = this->changes[c];
+                for(size_t i=c*STRIDE+1; i<=e; i++) { sum += uint64_t(llabs(this->value(i) - this->value(i-1))); }
+                return sum;
+            }
+
+        public:
+            // values are in [0, max_value], max_value picks the width
+            Timeline(uint32_t max_value = 0xffffffffu) : dense(false), length(0), last(-1), total_seconds(0),
+                                                         total_changes(0)
+            {
+                this->width = max_value <= 0xff ? 1 : max_value <= 0xffff ? 2 : 4;
+            }
+
+            // append m_t for the next second, false once the series is full
+            bool push(uint32_t m)
+            {
+                if(this->length > 0xffffffffull) { return false; }
+                if(this->dense || int64_t(m) != this->last) { this->open(m); }
+                this->total_seconds += m;
+                this->length++;
+
+                // a run costs 4 bytes more than a value, past half the seconds the array is smaller
+                if(!this->dense && this->length % 65536 == 0 && this->entries()*(4 + this->width) > this->length*this->width)
+                {
+                    this->densify();
+                }
+                return true;
+            }
+
+            void push(const int *m, size_t n)
+            {
+                for(size_t i=0; i<n; i++) { this->push(uint32_t(max(0, m[i]))); }
+            }
+
+            // settle the layout and drop the slack the vectors grew by
+            void shrink(void)
+            {
+                if(!this->dense && this->entries()*(4 + this->width) > this->length*this->width) { this->densify(); }
+                this->starts.shrink_to_fit();
+                this->values.shrink_to_fit();
+                this->seconds.shrink_to_fit();
+                this->changes.shrink_to_fit();
+            }
+
+            uint64_t size(void) const { return this->length; }
+            size_t runs(void) const { return this->dense ? 0 : this->starts.size(); }
+            bool is_dense(void) const { return this->dense; }
+            int get_width(void) const { return this->width; }
+
+            // held in memory, against 4 bytes a second for vector<int>
+            size_t bytes(void) const
+            {
+                return sizeof(*this) + this->starts.capacity()*sizeof(uint32_t) + this->values.capacity() +
+                       (this->seconds.capacity() + this->changes.capacity())*sizeof(uint64_t);
+            }
+
+            int at(uint64_t t) const { return t < this->length ? int(this->value(this->entry_of(t))) : 0; }
+
+            uint64_t server_seconds(uint64_t a, uint64_t b) const
+            {
+                b = min(b, this->length);
+                if(a >= b) { return 0; }
+                return this->seconds_before(b) - this->seconds_before(a);
+            }
+
+            uint64_t transitions(uint64_t a, uint64_t b) const
+            {
+                b = min(b, this->length);
+                if(a + 1 >= b) { return 0; }
+                return this->changes_through(b - 1) - this->changes_through(a);
+            }
+
+            vector<int> expand(void) const
+            {
+                vector<int> out(this->length);
+                for(size_t e=0; e<this->entries(); e++)
+                {
+                    fill(out.begin() + this->start(e), out.begin() + this->end(e), int(this->value(e)));
+                }
+                return out;
+            }
+    };
+
+    inline Timeline build(const vector<int> &m, uint32_t max_value)
+    {
+        Timeline t(max_value);
+        t.push(m.data(), m.size());
+        t.shrink();
+        return t;
+    }
+};
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Topology planning header file
+ *
+ * sizing and addressing for Network::build(): how many racks and nodes a
+ * fleet needs, what that will cost in memory, and an integer subnet
+ * allocator that replaces building prefixes out of strings
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+namespace topology
+{
+    /*
+     * bump allocator of aligned subnets out of one address block
+     */
+    class AddressPool
+    {
+        private:
+            uint32_t base, end, next;
+
+        public:
+            AddressPool() : base(0), end(0), next(0) {}
+
+            // block given as network address and prefix length, e.g. 10.0.0.0/8
+            AddressPool(uint32_t network, int prefix) : base(network), next(network)
+            {
+                this->end = network + uint32_t((uint64_t(1) << (32 - prefix)) - 1);
+            }
+
+            // smallest prefix with room for hosts plus network and broadcast
+            static int prefix_for(int hosts)
+            {
+                int bits = 2;
+                while((uint64_t(1) << bits) < uint64_t(hosts) + 2) { bits++; }
+                return 32 - bits;
+            }
+
+            static uint32_t mask(int prefix) { return prefix == 0 ? 0 : ~uint32_t(0) << (32 - prefix); }
+
+            /*
+             * next free subnet for a segment of hosts, false once the block
+             * is used up
+             */
+            bool allocate(int hosts, uint32_t &network, int &prefix)
+            {
+                prefix = prefix_for(hosts);
+                uint64_t size = uint64_t(1) << (32 - prefix);
+
+                uint64_t start = (uint64_t(this->next) + size - 1)/size*size;
+                if(start + size - 1 > this->end) { return false; }
+
+                network    = uint32_t(start);
+                this->next = uint32_t(start + size);
+                return true;
+            }
+
+            // how many subnets of this many hosts fit in what is left
+            uint64_t remaining(int hosts) const
+            {
+                uint64_t size  = uint64_t(1) << (32 - prefix_for(hosts));
+                uint64_t start = (uint64_t(this->next) + size - 1)/size*size;
+                return start > this->end ? 0 : (uint64_t(this->end) + 1 - start)/size;
+            }
+    };
+
+    inline uint32_t ipv4(int a, int b, int c, int d)
+    {
+        return (uint32_t(a) << 24) | (uint32_t(b) << 16) | (uint32_t(c) << 8) | uint32_t(d);
+    }
+
+    inline string dotted(uint32_t addr)
+    {
+        return to_string(addr >> 24) + "." + to_string((addr >> 16) & 255) + "." + to_string((addr >> 8) & 255) + "." +
+               to_string(addr & 255);
+    }
+
+    /*
+     * the address blocks Network uses: racks, each cluster's TOR segment,
+     * and the origin to cluster links
+     */
+    struct Addresses
+    {
+        AddressPool racks, tors, links;
+
+        Addresses() : racks(ipv4(10, 0, 0, 0), 8), tors(ipv4(172, 16, 0, 0), 12), links(ipv4(192, 168, 0, 0), 16) {}
+    };
+
+    // rough ns-3 footprint per object, calibrate with bench/bench_topology.cc
+    static const double NODE_BYTES      = 24 << 10;    // node, ipv4 stack, arp, udp/tcp, routing
+    static const double DEVICE_BYTES    = 3 << 10;     // net device and its queue
+    static const double CHANNEL_BYTES   = 1 << 10;
+    static const double INTERFACE_BYTES = 1 << 10;     // ipv4 interface and address
+
+    /*
+     * what Network::build() will create for a fleet. every cluster has
+     * servers hosts spread over floor(sqrt(servers)) racks, one TOR per rack
+     * on the cluster's aggregation segment with its aggregation switch, and
+     * a p2p link from that switch to the origin
+     */
+    struct Plan
+    {
+        int clusters, servers, racks, tors;
+        uint64_t nodes, devices, channels, interfaces;
+        double bytes;
+        bool fits;
+
+        // hosts in rack r of a cluster, racks differ by at most one
+        int rack_size(int r) const { return this->servers/this->racks + (r < this->servers % this->racks ? 1 : 0); }
+    };
+
+    // MPI rank of a cluster, contiguous blocks of clusters per rank
+    inline uint32_t owner(int cluster, int clusters, uint32_t ranks)
+    {
+        return clusters <= 0 ? 0 : uint32_t(uint64_t(cluster)*ranks/clusters);
+    }
+
+    inline Plan plan(int servers, int clusters)
+    {
+        Plan p;
+        p.clusters = clusters;
+        p.servers  = servers;
+        p.racks    = max(1, int(sqrt(double(servers))));
+        p.tors     = p.racks;
+
+        uint64_t c = clusters;
+        uint64_t origin = c + 1;
+
+        // origin nodes, aggregation switches, TORs and servers
+        p.nodes = origin + c*(1 + p.tors + servers);
+
+        // rack segments (servers + TOR), aggregation segments (TORs + switch),
+        // the origin segment and one p2p pair per cluster
+        p.devices    = c*(servers + p.racks) + c*(p.tors + 1) + origin + 2*c;
+        p.channels   = c*p.racks + c + 1 + c;
+        p.interfaces = c*(servers + p.racks) + c*(p.tors + 1) + 2*c;
+
+        p.bytes = p.nodes*NODE_BYTES + p.devices*DEVICE_BYTES + p.channels*CHANNEL_BYTES +
+                  p.interfaces*INTERFACE_BYTES;
+
+        Addresses a;
+        p.fits = a.racks.remaining(servers/p.racks + 2) >= c*p.racks && a.tors.remaining(p.tors + 1) >= c &&
+                 a.links.remaining(2) >= c;
+        return p;
+    }
+};
+#endif
@@ -0,0 +1,214 @@
+/*
+ * Trace loader header file
+ *
+ * author: Thato Semoko
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <charconv>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace trace
+{
+    /*
+     * read-only memory mapping of a whole file, unmapped on destruction
+     */
+    class MappedFile
+    {
+        private:
+            const char *bytes;
+            size_t length;
+
+        public:
+            MappedFile() : bytes(nullptr), length(0) {}
+
+            MappedFile(const string &filename) : bytes(nullptr), length(0)
+            {
+                int fd = ::open(filename.c_str(), O_RDONLY);
+                if(fd < 0) { return; }
+
+                struct stat st;
+                if(fstat(fd, &st) == 0 && st.st_size > 0)
+                {
+                    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if(addr != MAP_FAILED)
+                    {
+                        // the trace is read front to back
+                        madvise(addr, st.st_size, MADV_SEQUENTIAL);
+                        this->bytes  = static_cast<const char *>(addr);
+                        this->length = st.st_size;
+                    }
+                }
+                ::close(fd);
+            }
+
+            MappedFile(const MappedFile &) = delete;
+            MappedFile &operator=(const MappedFile &) = delete;
+
+            MappedFile(MappedFile &&other) : bytes(other.bytes), length(other.length)
+            {
+                other.bytes  = nullptr;
+                other.length = 0;
+            }
+
+            MappedFile &operator=(MappedFile &&other)
+            {
+                if(this != &other)
+                {
+                    this->unmap();
+                    this->bytes  = other.bytes;
+                    this->length = other.length;
+                    other.bytes  = nullptr;
+                    other.length = 0;
+                }
+                return *this;
+            }
+
+            ~MappedFile() { this->unmap(); }
+
+            void unmap(void)
+            {
+                if(this->bytes) { munmap(const_cast<char *>(this->bytes), this->length); }
+                this->bytes  = nullptr;
+                this->length = 0;
+            }
+
+            bool valid(void) const { return this->bytes != nullptr; }
+            const char *data(void) const { return this->bytes; }
+            const char *end(void) const { return this->bytes + this->length; }
+            size_t size(void) const { return this->length; }
+    };
+
+    // values in the trace are separated by commas and/or whitespace
+    inline bool is_separator(char c)
+    {
+        return c == ',' || c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    /*
+     * parse every number in [p, end) and append value/capacity to out.
+     * plain integer tokens (request counts) take a fast path that is exact
+     * up to 15 digits, anything else goes through from_chars, which rounds like stod
+     */
+    inline void parse_range(const char *p, const char *end, double capacity, vector<double> &out)
+    {
+        while(p < end)
+        {
+            while(p < end && is_separator(*p)) { p++; }
+            if(p == end) { break; }
+
+            const char *tok = p;
+            uint64_t value = 0;
+            int digits = 0;
+
+            while(p < end && *p >= '0' && *p <= '9' && digits < 15)
+            {
+                value = value*10 + (*p - '0');
+                p++; digits++;
+            }
+
+            if(digits > 0 && (p == end || is_separator(*p)))
+            {
+                out.push_back(double(value)/capacity);
+                continue;
+            }
+
+            // signs, decimals, exponents and long tokens
+            double d;
+            from_chars_result res = from_chars(tok, end, d);
+            if(res.ec == errc() && (res.ptr == end || is_separator(*res.ptr)))
+            {
+                out.push_back(d/capacity);
+                p = res.ptr;
+            }
+            else
+            {
+                // not a number (e.g. a header), skip the token
+                p = tok;
+                while(p < end && !is_separator(*p)) { p++; }
+            }
+        }
+    }
+
+    /*
+     * load a trace and normalise it by capacity. with threads > 1 the mapping
+     * is cut into chunks on separator boundaries and each chunk is parsed
+     * on its own thread, results are joined in file order
+     */
+    inline vector<double> load(const string &filename, double capacity, unsigned threads = 1)
+    {
+        vector<double> load_d;
+
+        MappedFile file(filename);
+        if(!file.valid())
+        {
+            // an empty file maps to nothing but is not an error
+            struct stat st;
+            if(stat(filename.c_str(), &st) != 0) { cerr << "File could not be opened!" << endl; }
+            return load_d;
+        }
+
+        // no point splitting below a megabyte per thread
+        size_t max_chunks = file.size()/(1 << 20) + 1;
+        if(threads < 1) { threads = 1; }
+        if(threads > max_chunks) { threads = max_chunks; }
+
+        if(threads == 1)
+        {
+            load_d.reserve(file.size()/8);
+            parse_range(file.data(), file.end(), capacity, load_d);
+            return load_d;
+        }
+
+        // chunk boundaries, each moved forward to the next separator
+        vector<const char *> bounds(threads + 1);
+        bounds[0]       = file.data();
+        bounds[threads] = file.end();
+        for(unsigned i=1; i<threads; i++)
+        {
+            const char *p = file.data() + (file.size()/threads)*i;
+            if(p < bounds[i-1]) { p = bounds[i-1]; }
+            while(p < file.end() && !is_separator(*p)) { p++; }
+            bounds[i] = p;
+        }
+
+        vector<vector<double>> parts(threads);
+        vector<thread> workers;
+        for(unsigned i=0; i<threads; i++)
+        {
+            workers.emplace_back([&, i]()
+            {
+                parts[i].reserve((bounds[i+1] - bounds[i])/8);
+                parse_range(bounds[i], bounds[i+1], capacity, parts[i]);
+            });
+        }
+        for(thread &w: workers) { w.join(); }
+
+        size_t total = 0;
+        for(vector<double> &part: parts) { total += part.size(); }
+
+        load_d.reserve(total);
+        for(vector<double> &part: parts)
+        {
+            load_d.insert(load_d.end(), part.begin(), part.end());
+            vector<double>().swap(part);
+        }
+
+        return load_d;
+    }
+};
+#endif
@@ -35,6 +35,10 @@ class Load : public Application
         uint32_t num_packets;
         uint32_t packet_size;
         uint32_t packets_sent;
+        uint32_t burst;             // packets sent per scheduled event
+        uint64_t events;            // send events run so far
+        Ptr<Packet> templ;          // payload shared by every packet sent
+        Ptr<ExponentialRandomVariable> gaps;    // poisson sends if set, mean 1
 
         DataRate        data_rate;
         EventId         send_event;
@@ -45,9 +49,13 @@ class Load : public Application
         {
             this->running      = true;
             this->packets_sent = 0;
+            this->events       = 0;
+            // copies of one packet share its buffer instead of allocating
+            this->templ        = Create<Packet> (this->packet_size);
             this->src_socket->Bind();
             this->src_socket->Connect(this->dest_addr);     // connect src to dest
-            this->send_packet();
+            // a flow at rate zero waits for set_rate()
+            if (this->data_rate.GetBitRate () > 0) { this->send_packet(); }
         }
 
         void StopApplication(void)
@@ -61,10 +69,16 @@ class Load : public Application
 
         void send_packet (void)
         {
-          Ptr<Packet> packet = Create<Packet> (this->packet_size);
-          this->src_socket->Send (packet);
+          this->events++;
 
-          if (++this->packets_sent < this->num_packets)
+          // send a burst per event, the gap to the next one keeps the average rate
+          for (uint32_t i = 0; i < this->burst && this->packets_sent < this->num_packets; i++)
+          {
+            this->src_socket->Send (this->templ->Copy ());
+            this->packets_sent++;
+          }
+
+          if (this->packets_sent < this->num_packets)
           {
             // schedule a transmission
            this->schedule_tx();
@@ -73,30 +87,64 @@ class Load : public Application
 
         void schedule_tx (void)
         {
-            if (this->running)
+            if (this->running && this->data_rate.GetBitRate () > 0)
             {
-                Time t_next (Seconds (this->packet_size * 8 / static_cast<double> (this->data_rate.GetBitRate ())));
+                double gap = this->burst * this->packet_size * 8 / static_cast<double> (this->data_rate.GetBitRate ());
+                if (this->gaps) { gap *= this->gaps->GetValue (); }
+                Time t_next (Seconds (gap));
                 this->send_event = Simulator::Schedule (t_next, &Load::send_packet, this);
             }
         }
 
     public:
         // default constructor
-        Load() : running(false), num_packets(0), packet_size(0), packets_sent(0),
+        Load() : running(false), num_packets(0), packet_size(0), packets_sent(0), burst(1), events(0), templ(0), gaps(0),
                  data_rate(0), send_event(), dest_addr(), src_socket(0)
         {}
 
         // default destructor
         ~Load() { this->src_socket = 0; }
 
-        void setup(Ptr<Socket> socket, Address addr, uint32_t p_size, uint32_t num_p, DataRate d_rate)
+        // burst > 1 trades per-packet pacing for fewer simulator events
+        void setup(Ptr<Socket> socket, Address addr, uint32_t p_size, uint32_t num_p, DataRate d_rate, uint32_t burst = 1)
         {
             this->num_packets = num_p;
             this->packet_size = p_size;
             this->data_rate   = d_rate;
             this->dest_addr   = addr;
             this->src_socket  = socket;
+            this->burst       = burst < 1 ? 1 : burst;
+        }
+
+        /*
+         * change the rate of a running flow, the next gap uses it. a flow
+         * idling at rate zero starts sending again
+         */
+        void set_rate(DataRate d_rate)
+        {
+            this->data_rate = d_rate;
+            if (this->running && !this->send_event.IsRunning () && this->packets_sent < this->num_packets)
+            {
+                this->schedule_tx();
+            }
         }
+
+        /*
+         * exponential gaps with the same mean instead of fixed ones, drawn
+         * from an ns-3 stream so RngSeedManager's seed and run decide them
+         */
+        void set_poisson(bool poisson)
+        {
+            this->gaps = 0;
+            if (poisson)
+            {
+                this->gaps = CreateObject<ExponentialRandomVariable> ();
+                this->gaps->SetAttribute ("Mean", DoubleValue (1.0));
+            }
+        }
+
+        uint32_t get_packets_sent(void) { return this->packets_sent; }
+        uint64_t get_events(void) { return this->events; }
         
 };
 #endif
@@ -1,5 +1,14 @@
 #include "network.h"
 #include "traffic.h"
+#include "trace.h"
+#include "binary_trace.h"
+#include "replay.h"
+#include "telemetry.h"
+#include "sink.h"
+#include "controller.h"
+#include "simprofile.h"
+#include "ensemble.h"
+#include "follow.h"
 #include <vector>
 #include <cmath>
 #include <iostream>
@@ -7,6 +16,11 @@
 #include <fstream>  // Needed for file stream objects
 #include <sstream>
 #include <time.h>
+#include <chrono>
+#include <thread>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "ns3/object.h"
 #include "ns3/uinteger.h"
@@ -14,121 +28,534 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/ipv4-flow-classifier.h"
 #include "ns3/ipv4-flow-probe.h"
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+#endif
 
 using namespace std;
 using namespace ns3;
 
-void export_data(string filename, vector<int> live_servers)
+// replaces filename with this run's results, .txt becomes .bin for binary
+void export_data(string filename, const vector<int> &live_servers, sink::Encoding encoding = sink::TEXT)
 {
-    // 
-    ofstream out(filename.c_str(), ios_base::app);
-    for(int server: live_servers)
+    INSTRUMENT("export_data");
+
+    if(encoding == sink::BINARY && filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".txt") == 0)
     {
-        out << server << endl;
+        filename.replace(filename.size() - 4, 4, ".bin");
     }
-    out.close();
+    if(!sink::write_file(filename, live_servers, encoding)) { cerr << "Could not write " << filename << "!" << endl; }
 }
 
-vector<double> load_data(string filename)
+vector<double> load_data(string filename, unsigned threads = 1, double from_hour = -1, double to_hour = -1)
 {
+    INSTRUMENT("load_data");
     // define server capacity
     int capacity = 0.75*20000*32;
 
-    // create a input file stream object
-    ifstream in_file(filename.c_str());
-    string line;
-    string time, data, error;
+    // binary traces (tools/trace_convert) are already normalised and can
+    // be cut to a window of hours without reading the rest of the file
+    if(trace::is_binary(filename))
+    {
+        trace::BinaryTrace bin(filename);
+        if(!bin.valid()) { cerr << "Invalid binary trace!" << endl; return vector<double>(); }
+        if(from_hour < 0 && to_hour < 0) { return bin.all(); }
 
-    vector<double> load_d;
+        int64_t begin = bin.t0() + int64_t(max(0.0, from_hour)*3600);
+        int64_t end   = to_hour < 0 ? INT64_MAX : bin.t0() + int64_t(to_hour*3600);
+        return bin.window(begin, end);
+    }
 
-    // check if the file exists
-    if(!in_file) { cerr << "File could not be opened!" << endl; }
+    if(from_hour >= 0 || to_hour >= 0) { cerr << "time windows need a binary trace, loading all of it" << endl; }
 
-    while(getline(in_file, line, ','))
-    {
-        istringstream iss(line); 
-        while(!iss.eof())
-        {
-            iss >>  data; 
-            // add to vector
-            load_d.push_back(stod(data)/capacity);
-        }
-    }
-   return load_d;
+    // the trace is memory mapped and parsed in place, optionally split
+    // across threads by chunk
+    return trace::load(filename, capacity, threads);
+}
+
+// one line of energy totals, and the per-window breakdown next to the results
+void report_energy(string name, energy::Meter &meter)
+{
+    meter.finish();
+    energy::Tally t = meter.get_totals();
+    cout << name << " energy: " << t.energy_j/3.6e6 << "kWh (" << t.wake_j/3.6e6 << "kWh waking " << t.wakes
+         << " servers), baseline " << t.baseline_j/3.6e6 << "kWh, saved "
+         << (t.baseline_j > 0 ? 100*t.saved()/t.baseline_j : 0) << "%, cost " << t.cost << endl;
+
+    if(!meter.get_windows().empty()) { meter.write_csv("./test_pcaps/energy_" + name + ".csv"); }
+}
+
+// how compactly a schedule keeps as a timeline, and what it adds up to
+void report_timeline(string name, const timeline::Timeline &t)
+{
+    cout << name << " timeline: " << (t.is_dense() ? string("dense") : to_string(t.runs()) + " runs") << ", "
+         << t.bytes()/1024 << "KB against " << t.size()*sizeof(int)/1024 << "KB, "
+         << t.server_seconds(0, t.size()) << " server-seconds, " << t.transitions(0, t.size()) << " transitions"
+         << endl;
+}
+
+// peak resident set size of this process in MB
+double peak_rss_mb(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss/1024.0;
 }
 
 int main(int argc, char *argv[])
 {
+    auto start = chrono::steady_clock::now();
 
     Time::SetResolution(Time::NS);
 
+    string trace_file = "./test_pcaps/data_new.csv";
+    unsigned int parse_threads = 1;
+    double from_hour = -1;
+    double to_hour = -1;
+    double kappa = 0.25;
+    int tau = 60;
+    double k = 100;
+    bool simulate = false;
     int num_servers = 8;
     int num_clusters = 22;
+    double threshold = 0.75;
+    uint32_t bucket = 1;
+    uint32_t burst = 1;
+    string peak_rate = "10Gbps";
+    string pcap_prefix = "";
+    bool distributed = false;
+    string telemetry_file = "";
+    double interval = 1;
+    string profile_file = "";
+    bool binary_out = false;
+    energy::PowerModel power;
+    uint64_t energy_window = 3600;
+    bool hierarchical = false;
+    double control = 0;
+    string forecast_method = "none";
+    forecast::Config forecast_config;
+    double skew = 0;
+    int64_t shift = 0;
+    string scheduler = "map";
+    double trial = 10;
+    string sim_profile = "";
+    uint32_t seed = 1;
+    uint32_t run = 1;
+    uint32_t replications = 1;
+    unsigned jobs = 0;
+    bool poisson = false;
+    string ensemble_file = "./test_pcaps/ensemble.csv";
+    string follow_state = "";
+    double every = 0;
 
-    // create the network with a load threshold of 0.75
-    cout << "setting up network..."<< endl;
-    Network cdn(num_servers, num_clusters, 0.75);
+    CommandLine cmd;
+    cmd.AddValue("trace", "per-second load trace to balance", trace_file);
+    cmd.AddValue("threads", "threads used to parse the trace and balance clusters", parse_threads);
+    cmd.AddValue("from", "first hour of a binary trace to balance", from_hour);
+    cmd.AddValue("to", "hour of a binary trace to stop at", to_hour);
+    cmd.AddValue("kappa", "fraction of the servers kept as live spares by online_lb", kappa);
+    cmd.AddValue("tau", "seconds a spare idles before online_lb hibernates it", tau);
+    cmd.AddValue("k", "cost of one server transition in server-seconds", k);
+    cmd.AddValue("simulate", "build the ns-3 topology for packet-level simulation", simulate);
+    cmd.AddValue("servers", "servers per cluster", num_servers);
+    cmd.AddValue("clusters", "clusters in the CDN", num_clusters);
+    cmd.AddValue("threshold", "load threshold of a server", threshold);
+    cmd.AddValue("bucket", "seconds of trace per traffic rate update", bucket);
+    cmd.AddValue("burst", "packets per send event of a replayed flow", burst);
+    cmd.AddValue("peak", "traffic into the CDN at a load of 1", peak_rate);
+    cmd.AddValue("pcap", "pcap file prefix for the rack access links", pcap_prefix);
+    cmd.AddValue("telemetry", "per-cluster flow statistics file, .bin for binary records", telemetry_file);
+    cmd.AddValue("interval", "simulated seconds per telemetry or profile record", interval);
+    cmd.AddValue("idle", "power of an idle live server (W)", power.idle_w);
+    cmd.AddValue("full", "power of a fully loaded server (W)", power.peak_w);
+    cmd.AddValue("sleep", "power of a hibernated server (W)", power.sleep_w);
+    cmd.AddValue("wake", "energy to wake a server (J)", power.wake_j);
+    cmd.AddValue("price", "cost of a kWh", power.price_kwh);
+    cmd.AddValue("window", "samples per energy breakdown window, 0 for totals only", energy_window);
+    cmd.AddValue("hierarchical", "also balance per cluster with load moved between clusters", hierarchical);
+    cmd.AddValue("skew", "zipf exponent of the trace's split over clusters", skew);
+    cmd.AddValue("shift", "seconds each cluster's demand lags the previous cluster's", shift);
+    cmd.AddValue("control", "control interval (s) of a balancer running in the simulation, 0 for none", control);
+    cmd.AddValue("forecast", "pre-warm servers from a forecast: none, ewma, hw or max", forecast_method);
+    cmd.AddValue("horizon", "seconds a server takes to wake, and the forecast horizon", forecast_config.horizon);
+    cmd.AddValue("binary", "write the result series as binary int32 instead of text", binary_out);
+    cmd.AddValue("profile", "CSV dump of the phase timings (needs -DLB_INSTRUMENT)", profile_file);
+    cmd.AddValue("scheduler", "event scheduler: map, heap, calendar, list, or auto to time each", scheduler);
+    cmd.AddValue("trial", "simulated seconds each scheduler is timed for by --scheduler=auto", trial);
+    cmd.AddValue("sim-profile", "CSV of events per second and queue depth over the simulation", sim_profile);
+    cmd.AddValue("seed", "seed of the simulation's random streams", seed);
+    cmd.AddValue("run", "run number of the random streams, replications count up from it", run);
+    cmd.AddValue("poisson", "exponential gaps between a flow's packets instead of fixed ones", poisson);
+    cmd.AddValue("replications", "independent seeded simulation runs, each in its own process", replications);
+    cmd.AddValue("jobs", "replications run at once, 0 for every core", jobs);
+    cmd.AddValue("ensemble", "CSV of each replication's results", ensemble_file);
+    cmd.AddValue("follow", "state file: balance only what was appended to the trace since the last run", follow_state);
+    cmd.AddValue("every", "with --follow, seconds between passes, 0 for a single pass", every);
+    cmd.AddValue("distributed", "split the simulation over MPI ranks by cluster (run under mpirun)", distributed);
+    cmd.Parse(argc, argv);
 
-    LoadBalancer lb;
+    // a growing trace: new decisions are appended to the results, nothing else runs
+    if(!follow_state.empty())
+    {
+        follow::Config config = {num_servers, threshold, kappa, tau, 0.75*20000*32};
+        follow::Follower follower(trace_file, follow_state, "./test_pcaps/live_servers.txt",
+                                  "./test_pcaps/server_transitions.txt", "./test_pcaps/online_servers.txt", config);
+        do
+        {
+            follow::Pass p = follower.step();
+            if(p.skipped) { cout << "follow: cannot read " << trace_file << ", pass skipped" << endl; }
+            else
+            {
+                if(p.restarted) { cout << "follow: no usable state for this trace, started from the beginning" << endl; }
+                cout << "follow: " << p.samples << " new samples (" << follower.get_state().samples << " in all) in "
+                     << p.seconds*1000 << "ms" << endl;
+            }
+            if(every > 0) { this_thread::sleep_for(chrono::duration<double>(every)); }
+        } while(every > 0);
+        return 0;
+    }
+
+    // rank 0 owns the origin and does the analytic work, the other ranks
+    // only simulate their share of the clusters
+    uint32_t rank = 0, ranks = 1;
+    if(distributed)
+    {
+#ifdef NS3_MPI
+        GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::DistributedSimulatorImpl"));
+        MpiInterface::Enable(&argc, &argv);
+        rank  = MpiInterface::GetSystemId();
+        ranks = MpiInterface::GetSize();
+        simulate = true;
+#else
+        cerr << "ns-3 was built without MPI, running sequentially" << endl;
+#endif
+    }
+
+    // time every scheduler on the first seconds of this same scenario, each
+    // in a child that runs the rest of main and reports back through a pipe
+    int trial_fd = -1;
+    if(simulate && scheduler == "auto" && ranks > 1)
+    {
+        cerr << "scheduler trials need a sequential run, using map" << endl;
+        scheduler = "map";
+    }
+    else if(simulate && scheduler == "auto")
+    {
+        cout << "timing schedulers over " << trial << " simulated seconds..." << endl;
+        string fastest = "map";
+        double best = -1;
+        for(int i=0; i<simprofile::NUM_SCHEDULERS; i++)
+        {
+            int fds[2];
+            if(pipe(fds) != 0) { break; }
+            cout.flush();
+            pid_t pid = fork();
+            if(pid == 0)
+            {
+                close(fds[0]);
+                trial_fd  = fds[1];
+                scheduler = simprofile::SCHEDULERS[i];
+                if(!freopen("/dev/null", "w", stdout)) { _exit(1); }
+                break;
+            }
+            close(fds[1]);
+            simprofile::Trial t;
+            bool ok = pid > 0 && read(fds[0], &t, sizeof(t)) == ssize_t(sizeof(t));
+            close(fds[0]);
+            if(pid > 0) { waitpid(pid, NULL, 0); }
+            if(!ok) { cerr << simprofile::SCHEDULERS[i] << " trial failed" << endl; continue; }
+
+            cout << "  " << simprofile::SCHEDULERS[i] << ": " << t.wall_s << "s, " << t.events/t.wall_s << " events/s" << endl;
+            if(best < 0 || t.wall_s < best) { best = t.wall_s; fastest = simprofile::SCHEDULERS[i]; }
+        }
+        if(trial_fd < 0)
+        {
+            scheduler = fastest;
+            cout << "using the " << scheduler << " scheduler" << endl;
+        }
+    }
     /*
-    vector<Server> servers = cdn.get_server_nodes();
+     * replications, each a child running the rest of main with its own run
+     * number, poisson sends so they differ. the parent only collects their
+     * results and then does the analytic work
+     */
+    int replica = -1, replica_fd = -1;
+    if(replications > 1 && (!simulate || ranks > 1))
+    {
+        cerr << "replications need --simulate and a sequential run" << endl;
+        replications = 1;
+    }
+    if(replications > 1 && trial_fd < 0)
+    {
+        poisson = true;
+        cout << "running " << replications << " replications from seed " << seed << " run " << run << "..." << endl;
+        vector<ensemble::Metrics> results;
+        replica = ensemble::spawn(replications, jobs, replica_fd, results);
+        if(replica >= 0)
+        {
+            run += replica;
+            if(!freopen("/dev/null", "w", stdout)) { _exit(1); }
+        }
+        else
+        {
+            uint32_t ok = 0;
+            for(const ensemble::Metrics &r: results) { ok += r.ok; }
+            cout << "ensemble: " << ok << "/" << replications << " replications, means with 95% confidence intervals" << endl;
+            for(int m=0; m<ensemble::NUM_METRICS; m++)
+            {
+                ensemble::Summary sum = ensemble::summarize(results, ensemble::Metric(m));
+                cout << "  " << ensemble::METRIC_NAMES[m] << ": " << sum.mean << " +- " << sum.half_width << " (sd "
+                     << sum.stddev << ")" << endl;
+            }
+            if(!ensemble::write_csv(ensemble_file, results)) { cerr << "Could not write " << ensemble_file << "!" << endl; }
+            simulate = false;
+        }
+    }
+    bool child = trial_fd >= 0 || replica >= 0;
+
+    RngSeedManager::SetSeed(seed);
+    RngSeedManager::SetRun(run);
 
-    cout << "creating traffic..."<< endl;
-    for(Server s: servers)
+    if(simulate && !simprofile::use(scheduler, !sim_profile.empty() && !child))
     {
-        for(unsigned int i=0; i<s.getNodes().GetN();i++ )
-        {
-            uint32_t sender   = i*2 % num_servers;
-
-            uint16_t sinkPort = 8080;
-            // string dest = "172.16.11.3";
-            Address sinkAddress (InetSocketAddress (s.getIPContainer().GetAddress(i), sinkPort));
-            PacketSinkHelper packetSinkHelper ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), sinkPort));
-            ApplicationContainer sinkApps = packetSinkHelper.Install (s.getNodes().Get(i));
-            sinkApps.Start (Seconds (0.));
-            sinkApps.Stop (Seconds (3600.));
-
-            // configure senders
-            Ptr<Socket> ns3TcpSocket = Socket::CreateSocket (s.getNodes().Get (sender), TcpSocketFactory::GetTypeId ());
-            //ns3TcpSocket->TraceConnectWithoutContext ("CongestionWindow", MakeCallback (&CwndChange));
-
-            // need to make different datarates
-            int rate = rand() % 100 +1;
-            uint32_t packets  = (rand() % 5000) + 400;
-            uint32_t p_size   = (rand() % 1000) + 400;
-            // simulate for an hour
-            uint32_t s_time   = (rand() % 1000) + 1;
-            uint32_t e_time   = (rand() % 3600) + 1800;
-
-            Ptr<Load> app = CreateObject<Load> ();
-            app->setup (ns3TcpSocket, sinkAddress, p_size, packets, DataRate (to_string(rate)+"Mbps"));
-            // install the load balancer on the incoming sockets
-            s.getNodes().Get (sender)->AddApplication (app);
-            app->SetStartTime (Seconds (s_time));
-            app->SetStopTime (Seconds (e_time));
+        cerr << "unknown scheduler " << scheduler << endl;
+        return 1;
+    }
 
-            CsmaHelper csma;
-            csma.EnablePcap("../../../../Documents/CDN/load_test", s.getNetDev().Get(0), true);
+    // create the network with a load threshold of 0.75, the algorithms only
+    // need the fleet description so the topology is built on request
+    Network cdn(num_servers, num_clusters, threshold);
+    if(simulate)
+    {
+        topology::Plan plan = cdn.plan();
+        if(rank == 0)
+        {
+            cout << "setting up network: " << plan.nodes << " nodes, " << plan.devices << " devices, ~"
+                 << plan.bytes/(1 << 20) << "MB predicted, " << ranks << " rank(s)..."<< endl;
         }
+        cdn.set_partition(rank, ranks);
+        cdn.build();
+        if(!cdn.is_built()) { return 1; }
     }
 
-    */
+    double startup = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if(rank == 0)
+    {
+        cout << (simulate ? "simulation" : "analytic") << " startup: " << startup*1000 << "ms, peak RSS "
+             << peak_rss_mb() << "MB" << endl;
+    }
+
+    LoadBalancer lb;
+
     // install a load balancer and
     // grab the load
-    cout << "running offline load balancing algorithm..."<< endl;
-    vector<int> l_servers = lb.offline_lb(cdn, load_data("./test_pcaps/data_new.csv"));
-    vector<int> transitions = lb.offline_lb2(cdn, load_data("./test_pcaps/data_new.csv"), 100);
-    export_data("./test_pcaps/live_servers.txt", l_servers);
-    export_data("./test_pcaps/server_transitions.txt", transitions);
+    if(rank == 0) { cout << "loading trace..."<< endl; }
+    // parsed once and shared by every algorithm
+    const vector<double> load = load_data(trace_file, parse_threads, from_hour, to_hour);
 
-    //cout << "exported data"<< endl;
+    // scheduler trials and replications only simulate
+    if(rank == 0 && !child)
+    {
+        sink::Encoding encoding = binary_out ? sink::BINARY : sink::TEXT;
 
-    /*
-    Simulator::Stop (Seconds (3600));
-    Simulator::Run ();
-    
-	Simulator::Destroy ();
-    */
+        cout << "running offline load balancing algorithm..."<< endl;
+        {
+            // the per-second series only lives as long as the export needs it
+            vector<int> l_servers, transitions;
+            lb.offline_lb2(cdn, load, l_servers, transitions);
+            export_data("./test_pcaps/live_servers.txt", l_servers, encoding);
+            export_data("./test_pcaps/server_transitions.txt", transitions, encoding);
+        }
+        report_timeline("offline", lb.offline_timeline(cdn, load));
+
+        // the schedules are metered from memory, the files are not read back.
+        // offline_lb's is worked out again a block at a time as it is metered
+        energy::Meter offline_meter(power, cdn.get_servers(), energy_window);
+        lb.offline_energy(cdn, load, offline_meter);
+        report_energy("offline", offline_meter);
+
+        cout << "running optimal offline algorithm..."<< endl;
+        optimal::Schedule opt = lb.offline_opt(cdn, load, k);
+        export_data("./test_pcaps/optimal_servers.txt", opt.servers, encoding);
+        report_timeline("optimal", timeline::build(opt.servers, cdn.get_servers()));
+        cout << "optimal: " << opt.server_seconds << " server-seconds, " << opt.transitions << " transitions, cost "
+             << opt.energy << " + " << opt.switching << " = " << opt.total << endl;
+
+        energy::Meter optimal_meter(power, cdn.get_servers(), energy_window);
+        optimal_meter.push(load.data(), opt.servers.data(), load.size());
+        report_energy("optimal", optimal_meter);
+
+        cout << "running online load balancing algorithm..."<< endl;
+        energy::Meter online_meter(power, cdn.get_servers(), energy_window);
+        vector<int> o_servers = lb.online_lb(cdn, load, kappa, tau, online_meter);
+        export_data("./test_pcaps/online_servers.txt", o_servers, encoding);
+        report_timeline("online", timeline::build(o_servers, cdn.get_servers()));
+        cout << "online: " << lb.get_online_totals().server_seconds << " server-seconds, "
+             << lb.get_online_totals().transitions << " transitions, "
+             << lb.get_online_totals().dropped << " load dropped" << endl;
+        report_energy("online", online_meter);
+
+        forecast_config.method = forecast::parse_method(forecast_method);
+        if(forecast_config.method != forecast::NONE)
+        {
+            cout << "running predictive load balancing (" << forecast::method_name(forecast_config.method) << ")..."<< endl;
+            vector<int> p_servers;
+            forecast::Config reactive = forecast_config;
+            reactive.method = forecast::NONE;
+            forecast::Outcome base = lb.predictive_lb(cdn, load, reactive, p_servers);
+            forecast::Outcome pred = lb.predictive_lb(cdn, load, forecast_config, p_servers);
+            export_data("./test_pcaps/predictive_servers.txt", p_servers, encoding);
+
+            cout << "predictive: " << pred.server_seconds << " server-seconds, " << pred.transitions << " transitions, "
+                 << pred.dropped << " load dropped, against offline_lb with a " << forecast_config.horizon
+                 << "s wake: " << base.transitions << " transitions, " << base.dropped << " dropped" << endl;
+        }
+
+        if(hierarchical)
+        {
+            cout << "running hierarchical load balancing over " << cdn.get_clusters() << " clusters..."<< endl;
+            hierarchy::Demand demand = hierarchy::split(load, cdn.get_clusters(), skew, shift);
+            hierarchy::Result h = lb.hierarchical_lb(cdn, demand, parse_threads);
+            export_data("./test_pcaps/hierarchical_servers.txt", h.total, encoding);
+
+            const hierarchy::Totals &t = h.totals;
+            cout << "hierarchical: " << t.server_seconds << " server-seconds, " << t.transitions << " transitions, "
+                 << t.excess << " excess load, " << t.shifted_live << " moved to live servers, " << t.shifted_woken
+                 << " moved to " << t.woken << " woken server-seconds, " << t.dropped << " dropped" << endl;
+        }
+
+        //cout << "exported data"<< endl;
+
+        cout << "peak RSS: " << peak_rss_mb() << "MB" << endl;
+    }
+
+    if(simulate)
+    {
+        // replay the trace through the topology, one rate update per bucket
+        if(rank == 0) { cout << "creating traffic..."<< endl; }
+        TraceReplayer replayer(load, bucket, DataRate(peak_rate), burst, poisson);
+        replayer.install(cdn);
+
+        // the online balancer inside the simulation, switching hosts as it goes
+        Ptr<BalancerApp> controller;
+        if(control > 0 && ranks > 1) { cerr << "the in-simulation balancer needs a sequential run" << endl; }
+        else if(control > 0)
+        {
+            controller = CreateObject<BalancerApp>();
+            controller->setup(&cdn, Seconds(control), DataRate(peak_rate), kappa, tau, &replayer);
+            controller->install();
+            controller->SetStartTime(Seconds(0.));
+            controller->SetStopTime(Seconds(replayer.duration()));
+        }
+
+        if(!pcap_prefix.empty() && !child)
+        {
+            CsmaHelper csma;
+            for(Server *rack: cdn.get_server_nodes())
+            {
+                if(cdn.is_local(rack->getNodes().Get(0))) { csma.EnablePcap(pcap_prefix, rack->getNetDev().Get(0), true); }
+            }
+        }
+
+        Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+        // a rank would only see the packets its own nodes send or receive and
+        // count every flow crossing ranks as lost, so telemetry is sequential
+        // only. a replication always counts flows and writes its own file
+        if(!telemetry_file.empty() && ranks > 1)
+        {
+            cerr << "telemetry needs a sequential run, none written" << endl;
+            telemetry_file = "";
+        }
+        unique_ptr<Telemetry> telemetry;
+        if((!telemetry_file.empty() && trial_fd < 0) || replica >= 0)
+        {
+            bool binary = telemetry_file.size() > 4 && telemetry_file.compare(telemetry_file.size() - 4, 4, ".bin") == 0;
+            string filename = telemetry_file;
+            if(replica >= 0 && !telemetry_file.empty()) { filename = telemetry_file + "." + to_string(replica); }
+            telemetry.reset(new Telemetry(filename, interval, binary));
+            telemetry->install(cdn);
+        }
+
+        unique_ptr<simprofile::Profiler> profiler;
+        if(!sim_profile.empty() && !child)
+        {
+            string filename = ranks > 1 ? sim_profile + "." + to_string(rank) : sim_profile;
+            profiler.reset(new simprofile::Profiler(filename, Seconds(interval)));
+            profiler->start();
+        }
+
+        if(rank == 0) { cout << "running simulation..."<< endl; }
+        double duration = trial_fd < 0 ? replayer.duration() : min(trial, replayer.duration());
+        auto run_start = chrono::steady_clock::now();
+        Simulator::Stop (Seconds (duration));
+        Simulator::Run ();
+        double run_wall = chrono::duration<double>(chrono::steady_clock::now() - run_start).count();
+
+        if(trial_fd >= 0)
+        {
+            simprofile::Trial t = {run_wall, Simulator::GetEventCount()};
+            bool sent = write(trial_fd, &t, sizeof(t)) == ssize_t(sizeof(t));
+            _exit(sent ? 0 : 1);
+        }
+
+        // flows live on rank 0, every rank reports its own wall time and memory
+        if(rank == 0) { replayer.report(cout); }
+        if(controller) { controller->report(cout); }
+        if(telemetry)
+        {
+            telemetry->finish();
+            telemetry->report(cout);
+        }
+        if(profiler)
+        {
+            if(!profiler->finish()) { cerr << "Could not write " << sim_profile << "!" << endl; }
+            profiler->report(cout);
+        }
+        if(replica >= 0)
+        {
+            ensemble::Metrics m = {};
+            m.replication = replica;
+            m.run = run;
+            m.ok  = 1;
+
+            const ClusterSample &flows = telemetry->get_total();
+            m.value[ensemble::WALL_S]      = run_wall;
+            m.value[ensemble::SEND_EVENTS] = replayer.get_stats().send_events;
+            m.value[ensemble::TX_PACKETS]  = flows.tx_packets;
+            m.value[ensemble::RX_PACKETS]  = flows.rx_packets;
+            m.value[ensemble::RX_BYTES]    = flows.rx_bytes;
+            m.value[ensemble::LOST]        = flows.lost;
+            m.value[ensemble::LOSS_RATE]   = flows.tx_packets ? double(flows.lost)/flows.tx_packets : 0;
+            m.value[ensemble::DELAY_MS]    = flows.rx_packets ? flows.delay_ns/1e6/flows.rx_packets : 0;
+            if(controller)
+            {
+                m.value[ensemble::TICKS]           = controller->get_stats().ticks;
+                m.value[ensemble::SWITCHED]        = controller->get_stats().switched;
+                m.value[ensemble::SPIKES]          = controller->get_stats().spikes;
+                m.value[ensemble::REACTION_P99_MS] = controller->get_reaction().quantile(0.99)/1e6;
+            }
+            bool sent = write(replica_fd, &m, sizeof(m)) == ssize_t(sizeof(m));
+            _exit(sent ? 0 : 1);
+        }
+
+        cout << "rank " << rank << "/" << ranks << ": simulation " << run_wall << "s, peak RSS " << peak_rss_mb()
+             << "MB" << endl;
+
+        Simulator::Destroy ();
+    }
+
+    // phase timings of this process
+    if(rank == 0) { instrument::report(cout); }
+    if(!profile_file.empty())
+    {
+        string filename = ranks > 1 ? profile_file + "." + to_string(rank) : profile_file;
+        if(!instrument::dump(filename)) { cerr << "no profile written, build with -DLB_INSTRUMENT" << endl; }
+    }
+
+#ifdef NS3_MPI
+    if(distributed) { MpiInterface::Disable(); }
+#endif
 
     return 0;
 }
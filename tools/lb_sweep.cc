@@ -0,0 +1,91 @@
+/*
+ * Load balancer parameter sweep
+ *
+ * loads a trace once and evaluates offline_lb2, offline_opt and online_lb over a grid
+ * of thresholds, kappa, tau, k and fleet sizes, one CSV row per point
+ *
+ *   g++ -O2 -std=c++17 -pthread -Ilib tools/lb_sweep.cc -o lb_sweep
+ *   ./lb_sweep data_new.csv sweep.csv --thresholds=0.6,0.75,0.9 --kappas=0.1,0.25
+ *              --taus=30,60,300 --ks=0.5,10,100 --servers=8,32,128 [--threads=<n>]
+ *
+ * author: Thato Semoko
+ */
+
+#include "binary_trace.h"
+#include "sweep.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+
+using namespace std;
+
+template <typename T>
+vector<T> parse_list(const string &s)
+{
+    vector<T> values;
+    stringstream ss(s);
+    string item;
+    while(getline(ss, item, ','))
+    {
+        T v;
+        istringstream(item) >> v;
+        values.push_back(v);
+    }
+    return values;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 3)
+    {
+        cerr << "usage: " << argv[0] << " <trace> <out.csv> [--thresholds=..] [--kappas=..] [--taus=..]"
+             << " [--ks=..] [--servers=..] [--threads=<n>]" << endl;
+        return 1;
+    }
+
+    sweep::Grid grid;
+    grid.thresholds = {0.75};
+    grid.kappas     = {0.25};
+    grid.taus       = {60};
+    grid.ks         = {100};
+    grid.servers    = {8};
+    unsigned threads = 0;
+
+    for(int i=3; i<argc; i++)
+    {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        string key = arg.substr(0, eq);
+        string value = eq == string::npos ? "" : arg.substr(eq + 1);
+
+        if(key == "--thresholds") { grid.thresholds = parse_list<double>(value); }
+        else if(key == "--kappas") { grid.kappas = parse_list<double>(value); }
+        else if(key == "--taus") { grid.taus = parse_list<int>(value); }
+        else if(key == "--ks") { grid.ks = parse_list<double>(value); }
+        else if(key == "--servers") { grid.servers = parse_list<int>(value); }
+        else if(key == "--threads") { threads = stoul(value); }
+        else { cerr << "unknown option " << arg << endl; return 1; }
+    }
+
+    // define server capacity, as in load_data()
+    int capacity = 0.75*20000*32;
+
+    auto start = chrono::steady_clock::now();
+    const vector<double> load = trace::load_any(argv[1], capacity, threads == 0 ? parallel::default_threads() : threads);
+    double t_load = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    vector<sweep::Point> points = sweep::expand(grid);
+
+    start = chrono::steady_clock::now();
+    vector<sweep::Row> rows = sweep::run(load, points, threads);
+    double t_sweep = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if(!sweep::write_csv(argv[2], rows)) { cerr << "File could not be opened!" << endl; return 1; }
+
+    cout << load.size() << " samples loaded in " << t_load << "s, " << points.size() << " points in " << t_sweep
+         << "s (" << points.size()*double(load.size())/t_sweep << " samples/s)" << endl;
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * Pcap aggregator
+ *
+ * turns a set of pcap captures (files, or directories of .pcap files)
+ * into the per-second request series load_data() reads, replacing the
+ * CSV export and re-aggregation in bin/data_process.py. captures are
+ * memory mapped and counted one file per task across threads, each file's
+ * buckets are merged into the total as it finishes
+ *
+ *   g++ -O2 -std=c++17 -pthread -Ilib tools/pcap_aggregate.cc -o pcap_aggregate
+ *   ./pcap_aggregate <out> <capture or directory>... [--bucket=<s>] [--threads=<n>] [--bytes]
+ *                    [--binary] [--capacity=<requests/s>] [--max-span=<s>]
+ *
+ * the output is one value per line, requests per second of each bucket
+ * (bytes per second with --bytes), or with --binary a trace for
+ * load_data() normalised by the capacity and stamped with capture time.
+ * packets more than --max-span seconds (a year by default) after the
+ * first are taken for corrupt timestamps and skipped
+ *
+ * author: Thato Semoko
+ */
+
+#include "pcap.h"
+#include "binary_trace.h"
+#include "parallel.h"
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <iostream>
+#include <algorithm>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// a directory stands for the .pcap files in it
+void expand(const string &path, vector<string> &files)
+{
+    struct stat st;
+    if(stat(path.c_str(), &st) != 0) { cerr << "cannot read " << path << endl; return; }
+    if(!S_ISDIR(st.st_mode)) { files.push_back(path); return; }
+
+    DIR *dir = opendir(path.c_str());
+    if(dir == NULL) { return; }
+    vector<string> found;
+    while(struct dirent *e = readdir(dir))
+    {
+        string name = e->d_name;
+        if(name.size() > 5 && name.compare(name.size() - 5, 5, ".pcap") == 0) { found.push_back(path + "/" + name); }
+    }
+    closedir(dir);
+
+    sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+}
+
+int main(int argc, char *argv[])
+{
+    string out_name;
+    vector<string> files;
+    uint32_t bucket = 1;
+    uint32_t span = pcap::MAX_SPAN;
+    unsigned threads = 0;
+    bool use_bytes = false, binary = false;
+    double capacity = 0.75*20000*32;     // as in load_data()
+
+    for(int i=1; i<argc; i++)
+    {
+        string arg = argv[i];
+        if(arg.rfind("--bucket=", 0) == 0) { bucket = max(1ul, stoul(arg.substr(9))); }
+        else if(arg.rfind("--threads=", 0) == 0) { threads = stoul(arg.substr(10)); }
+        else if(arg.rfind("--capacity=", 0) == 0) { capacity = stod(arg.substr(11)); }
+        else if(arg.rfind("--max-span=", 0) == 0) { span = uint32_t(max(1ul, min(stoul(arg.substr(11)), 0xfffffffful))); }
+        else if(arg == "--bytes") { use_bytes = true; }
+        else if(arg == "--binary") { binary = true; }
+        else if(arg.rfind("--", 0) == 0) { cerr << "unknown option " << arg << endl; return 1; }
+        else if(out_name.empty()) { out_name = arg; }
+        else { expand(arg, files); }
+    }
+
+    if(out_name.empty() || files.empty())
+    {
+        cerr << "usage: " << argv[0] << " <out> <capture or directory>... [--bucket=<s>] [--threads=<n>] [--bytes]"
+             << " [--binary] [--capacity=<requests/s>] [--max-span=<s>]" << endl;
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+
+    // the series starts at the earliest first packet of any capture
+    int64_t t0 = INT64_MAX;
+    for(const string &name: files)
+    {
+        trace::MappedFile file(name);
+        int64_t t = pcap::first_time(file);
+        if(t >= 0) { t0 = min(t0, t); }
+    }
+    if(t0 == INT64_MAX) { cerr << "no packets in any capture" << endl; return 1; }
+
+    pcap::Counts total(t0, bucket, span);
+    mutex merge;
+    uint64_t bytes_read = 0, skipped = 0;
+
+    parallel::parallel_for(files.size(), threads, [&](size_t i)
+    {
+        trace::MappedFile file(files[i]);
+        pcap::Counts counts(t0, bucket, span);
+        bool ok = pcap::count(file, counts);
+
+        lock_guard<mutex> guard(merge);
+        if(!ok) { skipped++; cerr << files[i] << " is not a pcap capture, skipped" << endl; return; }
+        total.add(counts);
+        bytes_read += file.size();
+    });
+    pcap::trim(total);
+
+    const vector<uint64_t> &series = use_bytes ? total.bytes : total.packets;
+    bool written;
+    if(binary)
+    {
+        vector<int64_t> times(series.size());
+        vector<double> load(series.size());
+        for(size_t b=0; b<series.size(); b++)
+        {
+            times[b] = t0 + int64_t(b)*bucket;
+            load[b]  = double(series[b])/bucket/capacity;
+        }
+        written = trace::write_binary(out_name, times, load, capacity, trace::LOAD_F64);
+    }
+    else
+    {
+        FILE *out = fopen(out_name.c_str(), "w");
+        written = out != NULL;
+        if(out)
+        {
+            setvbuf(out, NULL, _IOFBF, 1 << 20);
+            for(uint64_t v: series) { fprintf(out, "%llu\n", (unsigned long long)((v + bucket/2)/bucket)); }
+            written = fclose(out) == 0;
+        }
+    }
+    if(!written) { cerr << "could not write " << out_name << endl; return 1; }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    uint64_t packets = 0;
+    for(uint64_t p: total.packets) { packets += p; }
+
+    cout << files.size() - skipped << " captures, " << bytes_read/1e9 << "GB, " << packets << " packets into "
+         << series.size() << " buckets of " << bucket << "s in " << seconds << "s (" << bytes_read/1e9/seconds
+         << "GB/s)";
+    if(total.truncated) { cout << ", " << total.truncated << " truncated records"; }
+    if(total.late) { cout << ", " << total.late << " packets past the span skipped"; }
+    cout << endl;
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * Trace converter
+ *
+ * turns the per-second CSV written by bin/data_process.py into the binary
+ * columnar trace read by load_data(). lines are either "requests" (one
+ * second apart from --t0) or "time,requests"; repeated times are summed
+ *
+ *   g++ -O2 -std=c++17 -Ilib tools/trace_convert.cc -o trace_convert
+ *   ./trace_convert data_new.csv data_new.elb [--quantize] [--t0=<s>] [--stride=<n>]
+ *
+ * author: Thato Semoko
+ */
+
+#include "binary_trace.h"
+
+#include <vector>
+#include <string>
+#include <charconv>
+#include <iostream>
+
+using namespace std;
+
+// parse one number at p, false if the token is not numeric
+bool parse_field(const char *&p, const char *end, double &out)
+{
+    while(p < end && (*p == ' ' || *p == '\t')) { p++; }
+    from_chars_result res = from_chars(p, end, out);
+    if(res.ec != errc()) { return false; }
+    p = res.ptr;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 3)
+    {
+        cerr << "usage: " << argv[0] << " <in.csv> <out.elb> [--quantize] [--t0=<s>] [--stride=<n>]" << endl;
+        return 1;
+    }
+
+    string in_name  = argv[1];
+    string out_name = argv[2];
+    trace::LoadEncoding encoding = trace::LOAD_F64;
+    int64_t t0 = 0;
+    uint32_t stride = 4096;
+
+    for(int i=3; i<argc; i++)
+    {
+        string arg = argv[i];
+        if(arg == "--quantize") { encoding = trace::LOAD_U16; }
+        else if(arg.rfind("--t0=", 0) == 0) { t0 = stoll(arg.substr(5)); }
+        else if(arg.rfind("--stride=", 0) == 0) { stride = stoul(arg.substr(9)); }
+        else { cerr << "unknown option " << arg << endl; return 1; }
+    }
+
+    // define server capacity, as in load_data()
+    int capacity = 0.75*20000*32;
+
+    trace::MappedFile file(in_name);
+    if(!file.valid()) { cerr << "File could not be opened!" << endl; return 1; }
+
+    vector<int64_t> times;
+    vector<double> requests;
+    int64_t next_time = t0;
+
+    const char *p   = file.data();
+    const char *end = file.end();
+    while(p < end)
+    {
+        const char *eol = p;
+        while(eol < end && *eol != '\n') { eol++; }
+
+        double first, second;
+        const char *q = p;
+        if(parse_field(q, eol, first))
+        {
+            int64_t t = next_time;
+            double value = first;
+
+            if(q < eol && *q == ',')
+            {
+                q++;
+                // "time,requests", header lines fail here and are skipped
+                if(!parse_field(q, eol, second)) { p = eol + 1; continue; }
+                t = int64_t(first);
+                value = second;
+            }
+
+            if(!times.empty() && t < times.back())
+            {
+                cerr << "times go backwards at " << t << endl;
+                return 1;
+            }
+
+            if(!times.empty() && t == times.back()) { requests.back() += value; }
+            else
+            {
+                times.push_back(t);
+                requests.push_back(value);
+            }
+            next_time = t + 1;
+        }
+        p = eol + 1;
+    }
+
+    for(double &r: requests) { r /= capacity; }
+
+    if(!trace::write_binary(out_name, times, requests, capacity, encoding, stride)) { return 1; }
+
+    size_t width = encoding == trace::LOAD_U16 ? 2 : 8;
+    cout << "wrote " << requests.size() << " samples (" << (4 + width)*requests.size() << " column bytes) to "
+         << out_name << endl;
+    return 0;
+}